@@ -0,0 +1,55 @@
+#ifndef COLORMATH_H
+#define COLORMATH_H
+
+// 8-bit fixed-point color math, since the AVR has no FPU and float
+// arithmetic is done in software.
+//
+// A fraction is an amount out of 256. An amount of 255 counts as the whole,
+// so scaling by it leaves a channel as it is and blending by it reaches the
+// target color. Every kernel is a multiply and a shift on 16-bit values.
+
+#include <FastLED.h>
+
+namespace colormath
+{
+    // Scales a channel by scale / 256
+    inline uint8_t scale8(uint8_t channel, uint8_t scale)
+    {
+        return (uint8_t) (((uint16_t) channel * (scale + 1)) >> 8);
+    }
+
+    // Moves a channel from a towards b by amount / 256
+    inline uint8_t lerp8(uint8_t a, uint8_t b, uint8_t amount)
+    {
+        if (b >= a) {
+            return a + scale8(b - a, amount);
+        } else {
+            return a - scale8(a - b, amount);
+        }
+    }
+
+    inline CRGB scale(const CRGB &color, uint8_t scale)
+    {
+        return CRGB(scale8(color.r, scale), scale8(color.g, scale), scale8(color.b, scale));
+    }
+
+    // Moves a color from a towards b by amount / 256
+    inline CRGB blend(const CRGB &a, const CRGB &b, uint8_t amount)
+    {
+        return CRGB(lerp8(a.r, b.r, amount), lerp8(a.g, b.g, amount), lerp8(a.b, b.b, amount));
+    }
+
+    // The sine of theta / 256 of a turn, mapped to 1 to 255 around 128.
+    // Each half of the wave is a parabola, which stays within 6% of a sine
+    inline uint8_t sin8(uint8_t theta)
+    {
+        uint8_t half = theta & 0x7F;
+        uint16_t height = ((uint16_t) half * (128 - half)) >> 5;
+        if (height > 127) {
+            height = 127;
+        }
+        return (theta & 0x80) ? 128 - height : 128 + height;
+    }
+}
+
+#endif
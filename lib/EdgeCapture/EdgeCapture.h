@@ -0,0 +1,163 @@
+#ifndef EDGE_CAPTURE_H
+#define EDGE_CAPTURE_H
+
+// Captures the edges of a button pin as they happen, with the time of each,
+// so a press registers however long a frame takes.
+//
+// Sampling runs on the timer0 compare B interrupt, once per millisecond,
+// beside the overflow interrupt that drives millis(). Each change of level
+// is pushed with its millis() timestamp into a single-producer,
+// single-consumer ring buffer. The button on D4 (PD4) has no pin-change
+// interrupt on the ATmega32U4, so a timer interrupt is used instead. It keeps
+// sampling during Time::wait. While FastLED.show() has interrupts disabled,
+// the pending compare interrupt runs as soon as they are enabled again.
+//
+// Once per frame the main loop takes the edges with edgecapture::next() and
+// debounces them itself, at their timestamps rather than at the time of the
+// frame, see Setting::pressAt. Each edge also gives the level held until
+// it, so a level that lasted between two edges can settle even when both
+// came within one frame.
+//
+// In the simulator the sampler runs on every virtual millisecond.
+//
+// The interrupt handler is defined here, so only one translation unit may
+// include this header.
+
+#include <Arduino.h>
+
+#ifndef EDGE_CAPTURE_BUFFER
+#define EDGE_CAPTURE_BUFFER 8
+#endif
+
+// Keeps the compiler from moving memory accesses across it. The sampler
+// and the main loop run on one core, so this is all the ordering the ring
+// needs
+#define EDGE_CAPTURE_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+namespace edgecapture
+{
+    struct edge {
+        uint32_t time;
+        uint8_t level;
+    };
+
+    // Written only by the sampler and read only by the main loop. head is
+    // advanced after its slot is written and tail after its slot is read,
+    // with a barrier in between, so neither side needs to disable
+    // interrupts.
+    struct ring {
+        edge edges[EDGE_CAPTURE_BUFFER];
+        volatile uint8_t head;
+        volatile uint8_t tail;
+
+        bool push(const edge &e)
+        {
+            uint8_t next = (head + 1) % EDGE_CAPTURE_BUFFER;
+            if (next == tail) {
+                return false;
+            }
+            edges[head] = e;
+            EDGE_CAPTURE_BARRIER();
+            head = next;
+            return true;
+        }
+
+        bool pop(edge &e)
+        {
+            if (tail == head) {
+                return false;
+            }
+            EDGE_CAPTURE_BARRIER();
+            e = edges[tail];
+            EDGE_CAPTURE_BARRIER();
+            tail = (tail + 1) % EDGE_CAPTURE_BUFFER;
+            return true;
+        }
+    };
+
+    struct state {
+        ring edges;
+        uint8_t pin;
+        // Level of the last edge pushed
+        volatile uint8_t sampledLevel;
+        // Level of the last edge taken by the main loop
+        uint8_t takenLevel;
+    };
+
+    inline state &get()
+    {
+        static state s = {};
+        return s;
+    }
+
+    // Called from the sampling interrupt. While the ring is full a change
+    // is not recorded, and it is pushed by the first sample after the main
+    // loop makes room, if the pin still differs from the last edge pushed.
+    // So the edges always alternate and end at the level of the pin
+    inline void sample()
+    {
+        state &s = get();
+        uint8_t level = (digitalRead(s.pin) == HIGH) ? 1 : 0;
+        if (level != s.sampledLevel) {
+            edge e = { (uint32_t) millis(), level };
+            if (s.edges.push(e)) {
+                s.sampledLevel = level;
+            }
+        }
+    }
+
+    inline void begin(uint8_t pin)
+    {
+        state &s = get();
+        s.pin = pin;
+        s.sampledLevel = (digitalRead(pin) == HIGH) ? 1 : 0;
+        s.takenLevel = s.sampledLevel;
+#if defined(__AVR__)
+        OCR0B = 0x80;
+        TIMSK0 |= _BV(OCIE0B);
+#elif defined(SIM_H)
+        sim::get().tickHook = &sample;
+#endif
+    }
+
+    // Takes the oldest edge not taken yet and returns true, with the level
+    // the pin held until the edge in held. Once there are none left it
+    // returns false with the level of the last edge in both and a time up
+    // to which the pin is known to have kept it, as any later edge is
+    // stamped with that time or after.
+    inline bool next(uint8_t &held, uint8_t &level, uint32_t &time)
+    {
+        state &s = get();
+        uint32_t now = millis();
+        edge e;
+        held = s.takenLevel;
+        bool taken = s.edges.pop(e);
+        if (taken) {
+            s.takenLevel = e.level;
+            time = e.time;
+        } else {
+            time = now;
+        }
+        level = s.takenLevel;
+        return taken;
+    }
+
+    // Drops every edge captured so far
+    inline void discard()
+    {
+        uint8_t held;
+        uint8_t level;
+        uint32_t time;
+        while (next(held, level, time)) {
+        }
+    }
+}
+
+#if defined(__AVR__)
+ISR(TIMER0_COMPB_vect)
+{
+    edgecapture::sample();
+}
+#endif
+
+#endif
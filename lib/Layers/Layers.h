@@ -0,0 +1,311 @@
+#ifndef LAYERS_H
+#define LAYERS_H
+
+// Retained-mode layer stack composited into the FastLED buffer.
+//
+// Each layer keeps its own pixels between frames. A pixel is either set to
+// a color or transparent, and the composite shows the topmost set pixel of
+// each LED, or black, scaled by a brightness that applies to the whole
+// strip. The layers are numbered bottom to top:
+//   background  full-strip animations such as the finale
+//   progress    the time bars of the setting and timing modes
+//   cursor      the blinking setting cursor
+//
+// A layer is redrawn between layers::begin() and layers::end(). Pixels that
+// are written with the color they already have cost a comparison, and
+// pixels that were set before but not written in this pass are cleared at
+// end(). Only pixels that actually change, and a change of brightness, add
+// to a dirty range, and layers::composite() only recomputes that range. A
+// frame whose layers come out the same does no compositing at all.
+//
+// fill(), fillGradient(), copyRange() and scaleRange() write the half-open
+// range [first, last) of a layer in one loop over its pixels, and mark the
+// part of the range that changed dirty once.
+//
+// Every layer holds LAYERS_MAX_LEDS pixels, 3 bytes each plus two bits. It
+// defaults to the length of the strip, see lib/Strip/Strip.h. LEDs are
+// indexed with uint16_t, like the strip's length.
+
+#include <string.h>
+#include <FastLED.h>
+#include <Strip.h>
+#include <ColorMath.h>
+
+#ifndef LAYERS_MAX_LEDS
+#define LAYERS_MAX_LEDS STRIP_NUM_LEDS
+#endif
+
+namespace layers
+{
+    enum layer {
+        background,
+        progress,
+        cursor,
+        numLayers
+    };
+
+    const uint16_t maskBytes = (LAYERS_MAX_LEDS + 7) / 8;
+
+    struct pixels {
+        CRGB colors[LAYERS_MAX_LEDS];
+        // Pixels that are set, and pixels written since begin()
+        uint8_t set[maskBytes];
+        uint8_t written[maskBytes];
+    };
+
+    struct state {
+        pixels stack[numLayers];
+        uint8_t brightness;
+        // First and one past the last LED that needs compositing
+        uint16_t dirtyStart;
+        uint16_t dirtyEnd;
+    };
+
+    inline state &get()
+    {
+        static state s = { {}, 255, 0, LAYERS_MAX_LEDS };
+        return s;
+    }
+
+    inline bool test(const uint8_t *mask, uint16_t i)
+    {
+        return (mask[i >> 3] & (1 << (i & 7))) != 0;
+    }
+
+    inline void mark(uint16_t i)
+    {
+        state &s = get();
+        if (s.dirtyStart >= s.dirtyEnd) {
+            s.dirtyStart = i;
+            s.dirtyEnd = i + 1;
+        } else if (i < s.dirtyStart) {
+            s.dirtyStart = i;
+        } else if (i >= s.dirtyEnd) {
+            s.dirtyEnd = i + 1;
+        }
+    }
+
+    inline void markRange(uint16_t first, uint16_t last)
+    {
+        if (first < last) {
+            mark(first);
+            mark(last - 1);
+        }
+    }
+
+    inline void begin(uint8_t l)
+    {
+        memset(get().stack[l].written, 0, maskBytes);
+    }
+
+    inline void set(uint8_t l, uint16_t i, const CRGB &color)
+    {
+        if (i >= LAYERS_MAX_LEDS) {
+            return;
+        }
+        pixels &p = get().stack[l];
+        uint8_t bit = 1 << (i & 7);
+        p.written[i >> 3] |= bit;
+        if (!test(p.set, i) || (p.colors[i] != color)) {
+            p.colors[i] = color;
+            p.set[i >> 3] |= bit;
+            mark(i);
+        }
+    }
+
+    inline void end(uint8_t l)
+    {
+        pixels &p = get().stack[l];
+        for (uint16_t b = 0; b < maskBytes; b++) {
+            uint8_t stale = p.set[b] & ~p.written[b];
+            if (stale == 0) {
+                continue;
+            }
+            p.set[b] &= ~stale;
+            for (uint8_t bit = 0; bit < 8; bit++) {
+                if (stale & (1 << bit)) {
+                    mark(b * 8 + bit);
+                }
+            }
+        }
+    }
+
+    // Limits a range to the LEDs of a layer, returning false if it is empty
+    inline bool clip(uint16_t &first, uint16_t &last)
+    {
+        if (last > LAYERS_MAX_LEDS) {
+            last = LAYERS_MAX_LEDS;
+        }
+        return first < last;
+    }
+
+    // Writes color i of a range, keeping track of the part that changed
+    // whatever order the range is written in
+    inline void put(pixels &p, uint16_t i, const CRGB &color, uint16_t &changedFirst, uint16_t &changedLast)
+    {
+        uint8_t bit = 1 << (i & 7);
+        p.written[i >> 3] |= bit;
+        if (!(p.set[i >> 3] & bit) || (p.colors[i] != color)) {
+            p.colors[i] = color;
+            p.set[i >> 3] |= bit;
+            if (changedFirst >= changedLast) {
+                changedFirst = i;
+                changedLast = i + 1;
+            } else if (i < changedFirst) {
+                changedFirst = i;
+            } else if (i >= changedLast) {
+                changedLast = i + 1;
+            }
+        }
+    }
+
+    inline void fill(uint8_t l, uint16_t first, uint16_t last, const CRGB &color)
+    {
+        if (!clip(first, last)) {
+            return;
+        }
+        pixels &p = get().stack[l];
+        uint16_t changedFirst = 0;
+        uint16_t changedLast = 0;
+        for (uint16_t i = first; i < last; i++) {
+            put(p, i, color, changedFirst, changedLast);
+        }
+        markRange(changedFirst, changedLast);
+    }
+
+    // Fills a range with a linear gradient that starts at from and ends at
+    // to. The gradient is laid over the range as given, so when the range
+    // runs past the end of the strip only the part on the strip is drawn,
+    // in the colors it would have had anyway
+    inline void fillGradient(uint8_t l, uint16_t first, uint16_t last, const CRGB &from, const CRGB &to)
+    {
+        if (first >= last) {
+            return;
+        }
+        uint16_t span = last - first - 1;
+        if (!clip(first, last)) {
+            return;
+        }
+        if (from == to) {
+            fill(l, first, last, from);
+            return;
+        }
+        pixels &p = get().stack[l];
+        uint16_t changedFirst = 0;
+        uint16_t changedLast = 0;
+        // The position in the gradient, in 1/65536ths of the way to to
+        uint16_t step = (span == 0) ? 0 : 0xFFFF / span;
+        uint16_t position = 0;
+        for (uint16_t i = first; i < last; i++) {
+            put(p, i, colormath::blend(from, to, position >> 8), changedFirst, changedLast);
+            position += step;
+        }
+        markRange(changedFirst, changedLast);
+    }
+
+    // Copies the pixels of a range to the range of the same length at dest.
+    // Transparent pixels are copied too, and the ranges may overlap
+    inline void copyRange(uint8_t l, uint16_t first, uint16_t last, uint16_t dest)
+    {
+        if (!clip(first, last) || dest >= LAYERS_MAX_LEDS) {
+            return;
+        }
+        if ((uint32_t) dest + (last - first) > LAYERS_MAX_LEDS) {
+            last = first + (LAYERS_MAX_LEDS - dest);
+        }
+        pixels &p = get().stack[l];
+        uint16_t changedFirst = 0;
+        uint16_t changedLast = 0;
+        uint16_t count = last - first;
+        for (uint16_t k = 0; k < count; k++) {
+            // Copy backwards when the destination is ahead, as memmove does
+            uint16_t offset = (dest > first) ? count - 1 - k : k;
+            uint16_t from = first + offset;
+            uint16_t to = dest + offset;
+            if (test(p.set, from)) {
+                put(p, to, p.colors[from], changedFirst, changedLast);
+            } else {
+                p.written[to >> 3] |= 1 << (to & 7);
+                if (test(p.set, to)) {
+                    p.set[to >> 3] &= ~(1 << (to & 7));
+                    mark(to);
+                }
+            }
+        }
+        markRange(changedFirst, changedLast);
+    }
+
+    // Scales the set pixels of a range by factor / 256. Transparent pixels
+    // stay transparent
+    inline void scaleRange(uint8_t l, uint16_t first, uint16_t last, uint8_t factor)
+    {
+        if (!clip(first, last)) {
+            return;
+        }
+        pixels &p = get().stack[l];
+        uint16_t changedFirst = 0;
+        uint16_t changedLast = 0;
+        for (uint16_t i = first; i < last; i++) {
+            if (test(p.set, i)) {
+                put(p, i, colormath::scale(p.colors[i], factor), changedFirst, changedLast);
+            }
+        }
+        markRange(changedFirst, changedLast);
+    }
+
+    // Empties a layer
+    inline void clear(uint8_t l)
+    {
+        begin(l);
+        end(l);
+    }
+
+    inline void setBrightness(uint8_t brightness)
+    {
+        state &s = get();
+        if (brightness != s.brightness) {
+            s.brightness = brightness;
+            s.dirtyStart = 0;
+            s.dirtyEnd = LAYERS_MAX_LEDS;
+        }
+    }
+
+    // Empties every layer and restores full brightness
+    inline void reset()
+    {
+        for (uint8_t l = 0; l < numLayers; l++) {
+            clear(l);
+        }
+        setBrightness(255);
+    }
+
+    // Writes the dirty range of the composite into leds and returns whether
+    // any LED changed
+    inline bool composite(CRGB *leds)
+    {
+        state &s = get();
+        bool changed = false;
+        for (uint16_t i = s.dirtyStart; i < s.dirtyEnd; i++) {
+            CRGB color(0, 0, 0);
+            for (int8_t l = numLayers - 1; l >= 0; l--) {
+                const pixels &p = s.stack[l];
+                if (test(p.set, i)) {
+                    color = p.colors[i];
+                    break;
+                }
+            }
+            if (s.brightness != 255) {
+                color = colormath::scale(color, s.brightness);
+            }
+            if (leds[i] != color) {
+                leds[i] = color;
+                changed = true;
+            }
+        }
+        s.dirtyStart = 0;
+        s.dirtyEnd = 0;
+        return changed;
+    }
+}
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Per-frame profiler for the Program::main loop.
+//
+// PROFILE_MARK(stage) closes the stage that is currently being timed and
+// starts timing the named one, so a frame is a sequence of marks ending in
+// PROFILE_FRAME_END(). The last PROFILER_WINDOW durations of every stage are
+// kept in a ring buffer. Sending any byte over serial prints the min, average
+// and max of each stage together with a histogram of the window.
+//
+// The profiler only exists when built with -D HOURGLASS_PROFILE. Otherwise
+// every macro expands to nothing.
+
+#ifdef HOURGLASS_PROFILE
+
+#include <Arduino.h>
+
+#ifndef PROFILER_WINDOW
+#define PROFILER_WINDOW 16
+#endif
+
+#ifndef PROFILER_BAUD
+#define PROFILER_BAUD 115200
+#endif
+
+namespace profiler
+{
+    enum stage {
+        accelerometer,
+        modeFold,
+        settingExecute,
+        timingExecute,
+        pausedExecute,
+        finaleExecute,
+        show,
+        numStages,
+        none = numStages
+    };
+
+    // Histogram buckets are powers of two, from under 64us up to 4ms and more
+    const uint8_t numBuckets = 8;
+    const uint8_t firstBucketShift = 6;
+
+    struct stageLog {
+        uint16_t samples[PROFILER_WINDOW];
+        uint8_t next;
+        uint8_t count;
+    };
+
+    struct state {
+        stageLog stages[numStages];
+        uint8_t current;
+        uint32_t start;
+    };
+
+    inline state &get()
+    {
+        static state s = {};
+        return s;
+    }
+
+    inline const char *stageName(uint8_t st)
+    {
+        switch (st) {
+            case accelerometer: return "accelerometer";
+            case modeFold: return "modeFold";
+            case settingExecute: return "Setting::execute";
+            case timingExecute: return "Timing::execute";
+            case pausedExecute: return "Paused::execute";
+            case finaleExecute: return "Finale::execute";
+            case show: return "FastLed::show";
+        }
+        return "?";
+    }
+
+    inline void record(uint8_t st, uint32_t us)
+    {
+        stageLog &log = get().stages[st];
+        log.samples[log.next] = (us > 0xFFFF) ? 0xFFFF : (uint16_t) us;
+        log.next = (log.next + 1) % PROFILER_WINDOW;
+        if (log.count < PROFILER_WINDOW) {
+            log.count++;
+        }
+    }
+
+    inline void begin()
+    {
+        Serial.begin(PROFILER_BAUD);
+        get().current = none;
+    }
+
+    inline void mark(uint8_t next)
+    {
+        state &s = get();
+        uint32_t now = micros();
+        if (s.current != none) {
+            record(s.current, now - s.start);
+        }
+        s.current = next;
+        s.start = micros();
+    }
+
+    inline void dump()
+    {
+        state &s = get();
+        Serial.println("stage min avg max | <64us <128 <256 <512 <1ms <2ms <4ms >=4ms");
+        for (uint8_t st = 0; st < numStages; st++) {
+            const stageLog &log = s.stages[st];
+            if (log.count == 0) {
+                continue;
+            }
+            uint16_t minUs = 0xFFFF;
+            uint16_t maxUs = 0;
+            uint32_t total = 0;
+            uint8_t histogram[numBuckets] = {};
+            for (uint8_t i = 0; i < log.count; i++) {
+                uint16_t us = log.samples[i];
+                if (us < minUs) {
+                    minUs = us;
+                }
+                if (us > maxUs) {
+                    maxUs = us;
+                }
+                total += us;
+                uint8_t bucket = 0;
+                while ((bucket < numBuckets - 1) && (us >= ((uint16_t) 1 << (bucket + firstBucketShift)))) {
+                    bucket++;
+                }
+                histogram[bucket]++;
+            }
+            Serial.print(stageName(st));
+            Serial.print(' ');
+            Serial.print(minUs);
+            Serial.print(' ');
+            Serial.print(total / log.count);
+            Serial.print(' ');
+            Serial.print(maxUs);
+            Serial.print(" |");
+            for (uint8_t b = 0; b < numBuckets; b++) {
+                Serial.print(' ');
+                Serial.print(histogram[b]);
+            }
+            Serial.println();
+        }
+    }
+
+    inline void endFrame()
+    {
+        mark(none);
+        if (Serial.available() > 0) {
+            while (Serial.available() > 0) {
+                Serial.read();
+            }
+            dump();
+        }
+    }
+}
+
+#define PROFILE_BEGIN() profiler::begin()
+#define PROFILE_MARK(st) profiler::mark(profiler::st)
+#define PROFILE_FRAME_END() profiler::endFrame()
+
+#else
+
+#define PROFILE_BEGIN()
+#define PROFILE_MARK(st)
+#define PROFILE_FRAME_END()
+
+#endif
+
+#endif
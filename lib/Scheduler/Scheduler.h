@@ -0,0 +1,108 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+// Sleeps between frames of the Program::main loop instead of busy-polling.
+//
+// After a frame, scheduler::sleep() idles the MCU until the earliest of:
+//   - a wake requested through juniper::wake_at, for example the next
+//     Time::every pulse, the end of a button debounce interval or the next
+//     tick of a clock domain passed to Time::demand
+//   - HOURGLASS_POLL_INTERVAL ms after the frame started, as a bound on
+//     how long the loop can go without running
+//   - a change on a pin passed to scheduler::watch()
+//
+// On AVR the MCU sleeps in SLEEP_MODE_IDLE. Timer0 keeps running and wakes
+// it every millisecond, and each wake is used to check the deadline and the
+// watched pin. The button on D4 has no pin-change interrupt on the
+// ATmega32U4, so this check is how a press cuts a sleep short. On other
+// targets each step is a delay(1).
+//
+// Build with -D HOURGLASS_NO_SLEEP to run frames back to back as before. The
+// simulator's clock only moves when the program waits, so there a frame
+// that finds nothing due moves the clock on to the deadline instead, and
+// the frames between ticks are not simulated.
+
+#include <Arduino.h>
+#ifdef __AVR__
+#include <avr/sleep.h>
+#endif
+
+#ifndef HOURGLASS_POLL_INTERVAL
+#define HOURGLASS_POLL_INTERVAL 50
+#endif
+
+namespace scheduler
+{
+    const uint8_t noPin = 0xFF;
+
+    struct state {
+        uint32_t frameStart;
+        uint8_t watchedPin;
+        int watchedLevel;
+    };
+
+    inline state &get()
+    {
+        static state s = { 0, noPin, LOW };
+        return s;
+    }
+
+    // Wakes the loop early whenever the level of pin changes
+    inline void watch(uint8_t pin)
+    {
+        state &s = get();
+        s.watchedPin = pin;
+        s.watchedLevel = digitalRead(pin);
+    }
+
+    // Called at the start of every frame
+    inline void frameBegin()
+    {
+#ifdef SIM_H
+        sim::loop();
+#endif
+        get().frameStart = millis();
+    }
+
+    inline bool watchedPinChanged()
+    {
+        state &s = get();
+        return (s.watchedPin != noPin) && (digitalRead(s.watchedPin) != s.watchedLevel);
+    }
+
+    inline void idle()
+    {
+#ifdef __AVR__
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        sleep_enable();
+        sleep_cpu();
+        sleep_disable();
+#else
+        delay(1);
+#endif
+    }
+
+    inline void sleep()
+    {
+        state &s = get();
+        uint32_t deadline = s.frameStart + HOURGLASS_POLL_INTERVAL;
+        uint32_t requested;
+        if (juniper::take_wake(requested) && ((int32_t) (requested - deadline) < 0)) {
+            deadline = requested;
+        }
+#ifndef HOURGLASS_NO_SLEEP
+        while (((int32_t) (deadline - millis()) > 0) && !watchedPinChanged()) {
+            idle();
+        }
+#elif defined(SIM_H)
+        if ((int32_t) (deadline - millis()) > 0) {
+            delay(deadline - millis());
+        }
+#endif
+        if (s.watchedPin != noPin) {
+            s.watchedLevel = digitalRead(s.watchedPin);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef STRIP_H
+#define STRIP_H
+
+// LED strip whose chipset, data pin, color order and length are fixed at
+// compile time.
+//
+// The frame buffer is a static array sized by the template, so it takes no
+// heap and its length is a constant the compiler can see. FastLED is told
+// the color order when the buffer is registered and reorders the bytes as
+// it sends them, so the rest of the program writes CRGB values as they are
+// meant to look.
+
+#include <FastLED.h>
+
+#ifndef STRIP_NUM_LEDS
+#define STRIP_NUM_LEDS 33
+#endif
+
+namespace strip
+{
+    template<template<uint8_t DATA_PIN, EOrder RGB_ORDER> class CHIPSET, uint8_t PIN, EOrder ORDER, uint16_t NUM_LEDS>
+    struct config {
+        static const uint8_t pin = PIN;
+        static const uint16_t numLeds = NUM_LEDS;
+        static CRGB leds[NUM_LEDS];
+
+        // Registers the buffer with FastLED and returns it
+        static CRGB *begin()
+        {
+            FastLED.addLeds<CHIPSET, PIN, ORDER>(leds, NUM_LEDS);
+            return leds;
+        }
+    };
+
+    template<template<uint8_t DATA_PIN, EOrder RGB_ORDER> class CHIPSET, uint8_t PIN, EOrder ORDER, uint16_t NUM_LEDS>
+    CRGB config<CHIPSET, PIN, ORDER, NUM_LEDS>::leds[NUM_LEDS];
+
+    // The hourglass has WS2812 LEDs on pin 6, which take their colors in
+    // GRB order
+    typedef config<WS2812, 6, GRB, STRIP_NUM_LEDS> hourglass;
+}
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Input trace of the Program::main loop.
+//
+// Built with -D HOURGLASS_TRACE, every frame streams one binary record over
+// serial. The record holds the inputs the frame saw: millis() when it
+// began, the averaged reading of each accelerometer axis and the number of
+// button presses. Capture a session from the serial port, e.g.
+//   stty -F /dev/ttyACM0 raw 115200 && cat /dev/ttyACM0 > session.trace
+// and replay it in the simulator (env:native) with
+// HOURGLASS_SIM_REPLAY=session.trace. The replay sets the virtual clock to
+// the recorded time at the start of every frame and substitutes the
+// recorded readings, so the LED frames written to HOURGLASS_SIM_CAPTURE can
+// be compared with the device or with another build. A simulator run
+// records a trace of its own to HOURGLASS_SIM_TRACE.
+//
+// A record is TRACE_RECORD_SIZE bytes, little endian:
+//   0      TRACE_MARKER
+//   1-4    millis() at the start of the frame
+//   5-10   x, y and z readings
+//   11     button presses
+//   12     xor of bytes 1 to 11
+// The replay skips bytes until it finds a marker followed by a record with
+// a matching checksum, so a capture may start part way through a record.
+//
+// Without HOURGLASS_TRACE every macro expands to nothing. The trace shares
+// the serial port with the profiler, so only enable one of them.
+
+#ifdef HOURGLASS_TRACE
+
+#include <Arduino.h>
+
+#ifndef TRACE_BAUD
+#define TRACE_BAUD 115200
+#endif
+
+#define TRACE_MARKER 0xA5
+#define TRACE_RECORD_SIZE 13
+
+namespace trace
+{
+    const uint8_t numAxes = 3;
+
+    struct record {
+        uint32_t ms;
+        uint16_t axes[numAxes];
+        uint8_t presses;
+    };
+
+    struct state {
+        record current;
+        bool replaying;
+    };
+
+    inline state &get()
+    {
+        static state s = {};
+        return s;
+    }
+
+    inline uint8_t checksum(const uint8_t *bytes)
+    {
+        uint8_t sum = 0;
+        for (uint8_t i = 1; i < TRACE_RECORD_SIZE - 1; i++) {
+            sum ^= bytes[i];
+        }
+        return sum;
+    }
+
+    inline void encode(const record &r, uint8_t *bytes)
+    {
+        bytes[0] = TRACE_MARKER;
+        for (uint8_t i = 0; i < 4; i++) {
+            bytes[1 + i] = (uint8_t) (r.ms >> (8 * i));
+        }
+        for (uint8_t a = 0; a < numAxes; a++) {
+            bytes[5 + 2 * a] = (uint8_t) r.axes[a];
+            bytes[6 + 2 * a] = (uint8_t) (r.axes[a] >> 8);
+        }
+        bytes[11] = r.presses;
+        bytes[TRACE_RECORD_SIZE - 1] = checksum(bytes);
+    }
+
+    inline void decode(const uint8_t *bytes, record &r)
+    {
+        r.ms = 0;
+        for (uint8_t i = 0; i < 4; i++) {
+            r.ms |= (uint32_t) bytes[1 + i] << (8 * i);
+        }
+        for (uint8_t a = 0; a < numAxes; a++) {
+            r.axes[a] = (uint16_t) (bytes[5 + 2 * a] | (bytes[6 + 2 * a] << 8));
+        }
+        r.presses = bytes[11];
+    }
+
+#ifdef SIM_H
+    // Reads the next intact record of the replay, returning false at the end
+    inline bool next(record &r)
+    {
+        uint8_t bytes[TRACE_RECORD_SIZE];
+        if (!sim::replayRead(bytes, TRACE_RECORD_SIZE)) {
+            return false;
+        }
+        while (bytes[0] != TRACE_MARKER || checksum(bytes) != bytes[TRACE_RECORD_SIZE - 1]) {
+            memmove(bytes, bytes + 1, TRACE_RECORD_SIZE - 1);
+            if (!sim::replayRead(bytes + TRACE_RECORD_SIZE - 1, 1)) {
+                return false;
+            }
+        }
+        decode(bytes, r);
+        return true;
+    }
+#endif
+
+    inline void begin()
+    {
+#ifdef SIM_H
+        get().replaying = sim::replaying();
+#else
+        Serial.begin(TRACE_BAUD);
+#endif
+    }
+
+    inline void frameBegin()
+    {
+        state &s = get();
+        if (s.replaying) {
+#ifdef SIM_H
+            if (!next(s.current)) {
+                sim::finish();
+            }
+            sim::setMillis(s.current.ms);
+#endif
+        } else {
+            s.current.ms = millis();
+            s.current.presses = 0;
+        }
+    }
+
+    inline void frameEnd()
+    {
+        state &s = get();
+        if (s.replaying) {
+            return;
+        }
+        uint8_t bytes[TRACE_RECORD_SIZE];
+        encode(s.current, bytes);
+#ifdef SIM_H
+        sim::traceWrite(bytes, TRACE_RECORD_SIZE);
+#else
+        Serial.write(bytes, TRACE_RECORD_SIZE);
+#endif
+    }
+
+    // Axes are told apart by their pins, which are consecutive from A0
+    inline uint16_t analog(uint16_t pin, uint16_t value)
+    {
+        state &s = get();
+        uint16_t axis = pin - A0;
+        if (axis >= numAxes) {
+            return value;
+        }
+        if (s.replaying) {
+            return s.current.axes[axis];
+        }
+        s.current.axes[axis] = value;
+        return value;
+    }
+
+    inline uint8_t button(uint8_t presses)
+    {
+        state &s = get();
+        if (s.replaying) {
+            return s.current.presses;
+        }
+        s.current.presses = presses;
+        return presses;
+    }
+}
+
+#define TRACE_BEGIN() trace::begin()
+#define TRACE_FRAME_BEGIN() trace::frameBegin()
+#define TRACE_FRAME_END() trace::frameEnd()
+#define TRACE_ANALOG(pin, value) ((value) = trace::analog((pin), (value)))
+#define TRACE_BUTTON(presses) ((presses) = trace::button(presses))
+
+#else
+
+#define TRACE_BEGIN()
+#define TRACE_FRAME_BEGIN()
+#define TRACE_FRAME_END()
+#define TRACE_ANALOG(pin, value)
+#define TRACE_BUTTON(presses)
+
+#endif
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+// Stand-in for the Arduino core used by the host-native simulator. See
+// Sim.h for how inputs are scripted.
+
+#include <stdint.h>
+#include <math.h>
+#include <stdio.h>
+#include "Sim.h"
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define A0 18
+#define A1 19
+#define A2 20
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+inline void init()
+{
+    sim::begin();
+}
+
+inline unsigned long millis()
+{
+    return (unsigned long) (sim::get().nowUs / 1000);
+}
+
+inline unsigned long micros()
+{
+    return (unsigned long) sim::get().nowUs;
+}
+
+inline void delay(unsigned long ms)
+{
+    sim::sleepUs((uint64_t) ms * 1000);
+}
+
+inline void delayMicroseconds(unsigned int us)
+{
+    sim::sleepUs(us);
+}
+
+inline void pinMode(uint8_t, uint8_t) {}
+
+inline int digitalRead(uint8_t pin)
+{
+    return (pin < sim::numPins && sim::get().pins[pin] != 0) ? HIGH : LOW;
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (pin < sim::numPins) {
+        sim::get().pins[pin] = value;
+    }
+}
+
+inline int analogRead(uint8_t pin)
+{
+    return (pin < sim::numPins) ? sim::get().pins[pin] : 0;
+}
+
+inline void analogWrite(uint8_t pin, int value)
+{
+    digitalWrite(pin, (uint8_t) value);
+}
+
+// Serial output goes to stdout and there is never any input
+struct SimSerial {
+    void begin(unsigned long) {}
+    int available() { return 0; }
+    int read() { return -1; }
+
+    void print(const char *s) { fputs(s, stdout); }
+    void print(char c) { fputc(c, stdout); }
+    void print(double f, int places = 2) { printf("%.*f", places, f); }
+
+    void print(long n, int base = DEC)
+    {
+        if (base == DEC) {
+            printf("%ld", n);
+        } else {
+            print((unsigned long) n, base);
+        }
+    }
+
+    void print(unsigned long n, int base = DEC)
+    {
+        char buf[8 * sizeof(unsigned long) + 1];
+        char *p = &buf[sizeof(buf) - 1];
+        *p = '\0';
+        do {
+            unsigned long digit = n % base;
+            *--p = (char) (digit < 10 ? '0' + digit : 'A' + digit - 10);
+            n /= base;
+        } while (n != 0);
+        fputs(p, stdout);
+    }
+
+    void print(int n, int base = DEC) { print((long) n, base); }
+    void print(unsigned int n, int base = DEC) { print((unsigned long) n, base); }
+    void print(unsigned char n, int base = DEC) { print((unsigned long) n, base); }
+
+    void println() { fputc('\n', stdout); }
+
+    template<typename T>
+    void println(T value)
+    {
+        print(value);
+        println();
+    }
+};
+
+static SimSerial Serial;
+
+#endif
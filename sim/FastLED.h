@@ -0,0 +1,76 @@
+#ifndef FASTLED_H
+#define FASTLED_H
+
+// Stand-in for FastLED used by the host-native simulator. Every show()
+// hands the LED buffer to the simulator, which captures the frame with the
+// bytes of each LED in the order the strip receives them.
+
+#include <stdint.h>
+#include "Sim.h"
+
+struct CRGB {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+
+    CRGB() : r(0), g(0), b(0) {}
+    CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+};
+
+inline bool operator==(const CRGB &lhs, const CRGB &rhs)
+{
+    return (lhs.r == rhs.r) && (lhs.g == rhs.g) && (lhs.b == rhs.b);
+}
+
+inline bool operator!=(const CRGB &lhs, const CRGB &rhs)
+{
+    return !(lhs == rhs);
+}
+
+enum EOrder { RGB, RBG, GRB, GBR, BRG, BGR };
+
+template<uint8_t DATA_PIN, EOrder RGB_ORDER> class WS2812 {};
+
+#ifndef SIM_MAX_LEDS
+#define SIM_MAX_LEDS 256
+#endif
+
+class CFastLED {
+public:
+    CFastLED() : leds(NULL), numLeds(0), order(RGB) {}
+
+    template<template<uint8_t DATA_PIN, EOrder RGB_ORDER> class CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+    void addLeds(CRGB *data, int count)
+    {
+        leds = data;
+        numLeds = (count < SIM_MAX_LEDS) ? count : SIM_MAX_LEDS;
+        order = RGB_ORDER;
+    }
+
+    void show()
+    {
+        for (int i = 0; i < numLeds; i++) {
+            const CRGB &c = leds[i];
+            uint8_t *out = wire + (i * 3);
+            switch (order) {
+            case RGB: out[0] = c.r; out[1] = c.g; out[2] = c.b; break;
+            case RBG: out[0] = c.r; out[1] = c.b; out[2] = c.g; break;
+            case GRB: out[0] = c.g; out[1] = c.r; out[2] = c.b; break;
+            case GBR: out[0] = c.g; out[1] = c.b; out[2] = c.r; break;
+            case BRG: out[0] = c.b; out[1] = c.r; out[2] = c.g; break;
+            case BGR: out[0] = c.b; out[1] = c.g; out[2] = c.r; break;
+            }
+        }
+        sim::push(wire, numLeds);
+    }
+
+private:
+    CRGB *leds;
+    int numLeds;
+    EOrder order;
+    uint8_t wire[SIM_MAX_LEDS * 3];
+};
+
+static CFastLED FastLED;
+
+#endif
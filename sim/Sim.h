@@ -0,0 +1,348 @@
+#ifndef SIM_H
+#define SIM_H
+
+// Shared state for the host-native simulator build (env:native).
+//
+// The simulator stands in for the Arduino core and FastLED so that
+// src/main.cpp runs unchanged on the host. Time is virtual and only moves
+// forward through delay() and inputs come from a script. Every iteration
+// of the Program::main loop counts as a frame, through
+// scheduler::frameBegin(), and every FastLED.show() that reaches the strip
+// counts as a push and captures the LED frame. show() skips frames whose
+// LEDs did not change, so a section usually has fewer pushes than frames.
+//
+// The simulator is configured with environment variables:
+//   HOURGLASS_SIM_SCRIPT  input script, see below
+//   HOURGLASS_SIM_FRAMES  number of loop iterations to run (default 10000)
+//   HOURGLASS_SIM_CAPTURE file that every pushed frame is written to
+//   HOURGLASS_SIM_TRACE   file that the input trace is recorded to
+//   HOURGLASS_SIM_REPLAY  input trace to replay instead of the script inputs
+//
+// The input trace is only recorded and replayed in builds with
+// -D HOURGLASS_TRACE, see lib/Trace/Trace.h.
+//
+// A script line is "<ms> <key> <value>". From virtual time <ms> onwards
+// the key A0, A1, A2 or D4 reads <value>. The key "label" starts a new
+// statistics section named <value> and "end" stops the simulation. Lines
+// starting with # are comments. For example, flipping the hourglass onto
+// its side after two seconds:
+//   0    label setting
+//   0    A2    622
+//   2000 label timing
+//   2000 A0    612
+//   2000 A2    520
+//
+// This header replaces the global allocation functions, so it may only be
+// included by a single translation unit. main.cpp is the only one.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <new>
+
+namespace sim
+{
+    const int numPins = 32;
+    const int maxEvents = 256;
+    const int maxLabel = 32;
+
+    struct event {
+        uint64_t ms;
+        int pin;
+        int value;
+        char label[maxLabel];
+    };
+
+    struct section {
+        char label[maxLabel];
+        uint64_t frames;
+        uint64_t pushes;
+        uint64_t allocs;
+        uint64_t startMs;
+        std::chrono::steady_clock::time_point startWall;
+    };
+
+    struct state {
+        uint64_t nowUs;
+        int pins[numPins];
+        event events[maxEvents];
+        int numEvents;
+        int nextEvent;
+        uint64_t endMs;
+        uint64_t maxFrames;
+        uint64_t frames;
+        uint64_t pushes;
+        uint64_t allocs;
+        section current;
+        FILE *capture;
+        FILE *trace;
+        FILE *replay;
+        // Stands in for a timer interrupt, run on every virtual millisecond
+        void (*tickHook)();
+    };
+
+    inline state &get()
+    {
+        static state s;
+        return s;
+    }
+
+    // Analog pins follow the Arduino Micro numbering
+    const int pinA0 = 18;
+    const int pinA1 = 19;
+    const int pinA2 = 20;
+
+    inline int pinFromName(const char *name)
+    {
+        if (strcmp(name, "A0") == 0) {
+            return pinA0;
+        } else if (strcmp(name, "A1") == 0) {
+            return pinA1;
+        } else if (strcmp(name, "A2") == 0) {
+            return pinA2;
+        } else if (name[0] == 'D') {
+            return atoi(name + 1);
+        }
+        return -1;
+    }
+
+    inline void startSection(const char *label)
+    {
+        state &s = get();
+        strncpy(s.current.label, label, maxLabel - 1);
+        s.current.label[maxLabel - 1] = '\0';
+        s.current.frames = 0;
+        s.current.pushes = 0;
+        s.current.allocs = s.allocs;
+        s.current.startMs = s.nowUs / 1000;
+        s.current.startWall = std::chrono::steady_clock::now();
+    }
+
+    inline void endSection()
+    {
+        state &s = get();
+        if (s.current.frames == 0) {
+            return;
+        }
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - s.current.startWall).count();
+        printf("%-12s frames=%llu pushes=%llu virtual_ms=%llu loops/sec=%.0f ns/tick=%.0f allocs/frame=%.2f\n",
+               s.current.label,
+               (unsigned long long) s.current.frames,
+               (unsigned long long) s.current.pushes,
+               (unsigned long long) (s.nowUs / 1000 - s.current.startMs),
+               wall > 0 ? s.current.frames / wall : 0.0,
+               wall * 1e9 / s.current.frames,
+               (double) (s.allocs - s.current.allocs) / s.current.frames);
+    }
+
+    inline void finish()
+    {
+        state &s = get();
+        endSection();
+        if (s.capture != NULL) {
+            fclose(s.capture);
+        }
+        if (s.trace != NULL) {
+            fclose(s.trace);
+        }
+        fflush(stdout);
+        exit(0);
+    }
+
+    // Applies every script event that is due at the current virtual time
+    inline void advance()
+    {
+        state &s = get();
+        uint64_t ms = s.nowUs / 1000;
+        while (s.nextEvent < s.numEvents && s.events[s.nextEvent].ms <= ms) {
+            const event &e = s.events[s.nextEvent++];
+            if (e.pin >= 0) {
+                s.pins[e.pin] = e.value;
+            } else if (strcmp(e.label, "end") == 0) {
+                finish();
+            } else {
+                endSection();
+                startSection(e.label);
+            }
+        }
+    }
+
+    inline void loadScript(const char *path)
+    {
+        state &s = get();
+        FILE *f = fopen(path, "r");
+        if (f == NULL) {
+            fprintf(stderr, "sim: cannot open script %s\n", path);
+            exit(1);
+        }
+        char line[128];
+        while (fgets(line, sizeof(line), f) != NULL && s.numEvents < maxEvents) {
+            unsigned long long ms;
+            char key[maxLabel];
+            char value[maxLabel];
+            int fields = sscanf(line, "%llu %31s %31s", &ms, key, value);
+            if (line[0] == '#' || fields < 2) {
+                continue;
+            }
+            event &e = s.events[s.numEvents];
+            e.ms = ms;
+            e.pin = -1;
+            e.value = 0;
+            e.label[0] = '\0';
+            if (strcmp(key, "label") == 0 && fields == 3) {
+                strcpy(e.label, value);
+            } else if (strcmp(key, "end") == 0) {
+                strcpy(e.label, "end");
+            } else {
+                int pin = pinFromName(key);
+                if (pin < 0 || pin >= numPins || fields != 3) {
+                    fprintf(stderr, "sim: bad script line: %s", line);
+                    exit(1);
+                }
+                e.pin = pin;
+                e.value = atoi(value);
+            }
+            s.numEvents++;
+        }
+        fclose(f);
+    }
+
+    inline void begin()
+    {
+        state &s = get();
+        // Resting on the base: z points up and the button is released
+        s.pins[pinA0] = 508;
+        s.pins[pinA1] = 515;
+        s.pins[pinA2] = 622;
+        const char *frames = getenv("HOURGLASS_SIM_FRAMES");
+        s.maxFrames = (frames != NULL) ? strtoull(frames, NULL, 10) : 10000;
+        const char *script = getenv("HOURGLASS_SIM_SCRIPT");
+        if (script != NULL) {
+            loadScript(script);
+        }
+        const char *capture = getenv("HOURGLASS_SIM_CAPTURE");
+        if (capture != NULL) {
+            s.capture = fopen(capture, "w");
+        }
+        const char *trace = getenv("HOURGLASS_SIM_TRACE");
+        if (trace != NULL) {
+            s.trace = fopen(trace, "wb");
+        }
+        const char *replay = getenv("HOURGLASS_SIM_REPLAY");
+        if (replay != NULL) {
+            s.replay = fopen(replay, "rb");
+            if (s.replay == NULL) {
+                fprintf(stderr, "sim: cannot open trace %s\n", replay);
+                exit(1);
+            }
+        }
+        startSection("run");
+        advance();
+    }
+
+    inline void sleepUs(uint64_t us)
+    {
+        state &s = get();
+        uint64_t end = s.nowUs + us;
+        while (s.nowUs < end) {
+            uint64_t nextTick = (s.nowUs / 1000 + 1) * 1000;
+            bool ticked = nextTick <= end;
+            s.nowUs = ticked ? nextTick : end;
+            advance();
+            if (ticked && s.tickHook != NULL) {
+                s.tickHook();
+            }
+        }
+    }
+
+    // Moves the virtual clock to a replayed frame's time. A replay follows
+    // the trace even where that is earlier than the simulated sleep ended.
+    inline void setMillis(uint32_t ms)
+    {
+        get().nowUs = (uint64_t) ms * 1000;
+        advance();
+    }
+
+    inline bool replaying()
+    {
+        return get().replay != NULL;
+    }
+
+    inline bool replayRead(uint8_t *bytes, size_t n)
+    {
+        return fread(bytes, 1, n, get().replay) == n;
+    }
+
+    inline void traceWrite(const uint8_t *bytes, size_t n)
+    {
+        state &s = get();
+        if (s.trace != NULL) {
+            fwrite(bytes, 1, n, s.trace);
+        }
+    }
+
+    // Called at the start of every iteration of the main loop
+    inline void loop()
+    {
+        state &s = get();
+        if (s.frames >= s.maxFrames) {
+            finish();
+        }
+        s.frames++;
+        s.current.frames++;
+    }
+
+    // Called by FastLED.show() with the LED buffer in wire order
+    inline void push(const uint8_t *rgb, int numLeds)
+    {
+        state &s = get();
+        if (s.capture != NULL) {
+            fprintf(s.capture, "%llu", (unsigned long long) (s.nowUs / 1000));
+            for (int i = 0; i < numLeds; i++) {
+                fprintf(s.capture, " %02x%02x%02x", rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]);
+            }
+            fprintf(s.capture, "\n");
+        }
+        s.pushes++;
+        s.current.pushes++;
+    }
+}
+
+void *operator new(size_t size)
+{
+    sim::get().allocs++;
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return ::operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    free(p);
+}
+
+#endif
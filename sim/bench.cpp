@@ -0,0 +1,444 @@
+// Host benchmarks for the runtime, the modes and the layer stack, built
+// against the stand-in headers like the simulator. Each case prints its
+// label, the time per operation and the heap allocations per operation, the
+// best of HOURGLASS_BENCH_RUNS runs (5 by default). Build and run it with
+// sim/bench.sh, which can also build it against earlier revisions of
+// src/main.cpp to compare a change with its parent.
+//
+// The cases only use functions that every revision of main.cpp since the
+// simulator has. The layer cases are left out of revisions without
+// lib/Layers. The fill cases are left out of those without layers::fill,
+// for which sim/bench.sh defines BENCH_NO_FILL, and the copy and scale
+// cases out of those without layers::copyRange, for which it defines
+// BENCH_NO_COPY. Likewise BENCH_NO_HISTORY leaves out the ring history case
+// where there is no Signal::history, and BENCH_NO_BATCH the batch case where
+// there are no Signal::latest and Signal::count.
+
+#ifndef BENCH_MAIN
+#define BENCH_MAIN "../src/main.cpp"
+#endif
+
+#define main hourglass_main
+#include BENCH_MAIN
+#undef main
+
+#include <chrono>
+#include <string.h>
+
+namespace bench
+{
+    struct result {
+        std::chrono::steady_clock::time_point start;
+        uint64_t allocs;
+    };
+
+    inline result begin()
+    {
+        result r;
+        r.allocs = sim::get().allocs;
+        r.start = std::chrono::steady_clock::now();
+        return r;
+    }
+
+    // The best of the runs of each case, in the order they first finished
+    const int maxCases = 32;
+    const char *labels[maxCases];
+    double bestNs[maxCases];
+    double bestAllocs[maxCases];
+    int numCases = 0;
+
+    inline void end(const char *label, const result &r, uint32_t ops)
+    {
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - r.start).count() / ops;
+        double allocs = (double) (sim::get().allocs - r.allocs) / ops;
+        int i = 0;
+        while (i < numCases && strcmp(labels[i], label) != 0) {
+            i++;
+        }
+        if (i == numCases) {
+            labels[numCases++] = label;
+            bestNs[i] = ns;
+            bestAllocs[i] = allocs;
+        } else if (ns < bestNs[i]) {
+            bestNs[i] = ns;
+            bestAllocs[i] = allocs;
+        }
+    }
+
+    void print()
+    {
+        for (int i = 0; i < numCases; i++) {
+            printf("%-20s %10.1f ns/op %8.2f allocs/op\n", labels[i], bestNs[i], bestAllocs[i]);
+        }
+    }
+
+    // Moves the virtual clock on and runs the sampling interrupt once
+    inline void step(uint32_t ms)
+    {
+        sim::setMillis(ms);
+        if (sim::get().tickHook != NULL) {
+            sim::get().tickHook();
+        }
+    }
+
+    volatile int32_t sink;
+
+    // A closure of three words is built, copied and called, as the signal
+    // combinators do with their arguments every frame
+    void functionCopy()
+    {
+        const uint32_t ops = 1000000;
+        int32_t a = 1, b = 2, c = 3;
+        result r = begin();
+        for (uint32_t i = 0; i < ops; i++) {
+            juniper::function<int32_t(int32_t)> f([=](int32_t x) mutable -> int32_t { return x + a + b + c; });
+            juniper::function<int32_t(int32_t)> g = f;
+            sink = f(i) + g(i);
+            a = sink;
+        }
+        end("function.copy", r, ops);
+    }
+
+    // A shared_ptr is passed down four levels by value, as generated code
+    // passes refs to the library
+    int32_t passRef(juniper::shared_ptr<int32_t> p, int depth)
+    {
+        return depth == 0 ? *p.get() : passRef(p, depth - 1);
+    }
+
+    void sharedPtrPass()
+    {
+        const uint32_t ops = 1000000;
+        juniper::shared_ptr<int32_t> p(new int32_t(7));
+        result r = begin();
+        for (uint32_t i = 0; i < ops; i++) {
+            sink = passRef(p, 4);
+        }
+        end("shared_ptr.pass", r, ops);
+    }
+
+    // mergeMany, sum and == over a 256 element list
+    void listFolds()
+    {
+        const uint32_t ops = 2000;
+        const int n = 256;
+        static Prelude::list<Prelude::sig<int32_t>, n> sigs;
+        static Prelude::list<int32_t, n> values;
+        sigs.length = n;
+        values.length = n;
+        for (int i = 0; i < n; i++) {
+            sigs.data[i] = Prelude::signal<int32_t>(Prelude::nothing<int32_t>());
+            values.data[i] = i;
+        }
+        result r = begin();
+        for (uint32_t i = 0; i < ops; i++) {
+            sink = Signal::mergeMany<int32_t, n>(sigs).signal.tag;
+            sink = List::sum<int32_t, n>(values);
+            sink = values == values;
+        }
+        end("list.folds", r, ops);
+    }
+
+    // A 128 sample history of a signal, recorded into a list or pushed into
+    // a ring, and averaged on every event
+    void historyRecord()
+    {
+        const uint32_t ops = 200000;
+        const int n = 128;
+        juniper::shared_ptr<Prelude::list<int32_t, n>> past(new Prelude::list<int32_t, n>());
+        result r = begin();
+        for (uint32_t i = 0; i < ops; i++) {
+            Prelude::sig<Prelude::list<int32_t, n>> recorded = Signal::record<int32_t, n>(Prelude::signal<int32_t>(Prelude::just<int32_t>(i & 0x3FF)), past);
+            sink = List::average<int32_t, n>(recorded.signal.just);
+        }
+        end("history.record", r, ops);
+    }
+
+#ifndef BENCH_NO_HISTORY
+    void historyRing()
+    {
+        const uint32_t ops = 200000;
+        const int n = 128;
+        juniper::shared_ptr<juniper::ring<int32_t, n>> samples(new juniper::ring<int32_t, n>());
+        result r = begin();
+        for (uint32_t i = 0; i < ops; i++) {
+            Prelude::sig<juniper::ring_window<int32_t, n>> window = Signal::history<int32_t, n>(Prelude::signal<int32_t>(Prelude::just<int32_t>(i & 0x3FF)), samples);
+            sink = List::average<int32_t, n>(window.signal.just);
+        }
+        end("history.ring", r, ops);
+    }
+#endif
+
+#ifndef BENCH_NO_BATCH
+    // A batch of up to 7 events, more than it holds, coalesced by each
+    // policy: the newest event, the number of events and a fold over them
+    int32_t addEvent(int32_t event, int32_t total)
+    {
+        return total + event;
+    }
+
+    void batchCoalesce()
+    {
+        const uint32_t ops = 1000000;
+        juniper::shared_ptr<int32_t> state(new int32_t(0));
+        result r = begin();
+        for (uint32_t i = 0; i < ops; i++) {
+            Prelude::sig<juniper::batch<int32_t, 4>> events = Signal::repeated<int32_t, 4>(i & 0x3FF, i & 7);
+            sink = Signal::latest<int32_t, 4>(events).signal.tag;
+            sink = Signal::count<int32_t, 4>(events).signal.tag;
+            sink = Signal::foldP<int32_t, int32_t, 4>(juniper::function_ref<int32_t(int32_t, int32_t)>(addEvent), state, events).signal.tag;
+        }
+        end("batch.coalesce", r, ops);
+    }
+#endif
+
+    // Setting with the cursor blinking and a press every 300 ms, 5 ms apart
+    void setting()
+    {
+        const uint32_t ops = 200000;
+        juniper::shared_ptr<int32_t> timeRemaining(new int32_t(0));
+        uint32_t t = 1000;
+        step(t);
+        Setting::reset(timeRemaining);
+        result r = begin();
+        for (uint32_t i = 0; i < ops; i++) {
+            t += 5;
+            sim::get().pins[Constants::buttonPin] = (i % 60) < 30;
+            step(t);
+            Setting::execute(timeRemaining);
+            if ((i % 6000) == 0) {
+                Setting::reset(timeRemaining);
+            }
+        }
+        end("setting.execute", r, ops);
+    }
+
+    // A 30 s countdown drawn every 20 ms, over and over
+    void timing()
+    {
+        const uint32_t ops = 200000;
+        const int32_t totalTime = 30000;
+        juniper::shared_ptr<int32_t> timeRemaining(new int32_t(totalTime));
+        uint32_t t = 1000;
+        step(t);
+        Timing::reset();
+        result r = begin();
+        for (uint32_t i = 0; i < ops; i++) {
+            t += 20;
+            step(t);
+            Timing::execute(timeRemaining, totalTime);
+            if (*timeRemaining.get() <= 0) {
+                *timeRemaining.get() = totalTime;
+            }
+        }
+        end("timing.execute", r, ops);
+    }
+
+    // The countdown held at half way, pulsing
+    void paused()
+    {
+        const uint32_t ops = 200000;
+        const int32_t totalTime = 30000;
+        juniper::shared_ptr<int32_t> timeRemaining(new int32_t(totalTime / 2));
+        uint32_t t = 1000;
+        step(t);
+        Timing::reset();
+        result r = begin();
+        for (uint32_t i = 0; i < ops; i++) {
+            t += 20;
+            step(t);
+            Paused::execute(timeRemaining, totalTime);
+        }
+        end("paused.execute", r, ops);
+    }
+
+    // The finale animation, 20 ms apart
+    void finale()
+    {
+        const uint32_t ops = 100000;
+        uint32_t t = 1000;
+        result r = begin();
+        for (uint32_t i = 0; i < ops; i++) {
+            t += 20;
+            step(t);
+            Finale::execute();
+        }
+        end("finale.execute", r, ops);
+    }
+
+#ifdef LAYERS_H
+    CRGB leds[LAYERS_MAX_LEDS];
+
+    // Moves a color from a towards b by amount / 256, as a mode without
+    // fillGradient would per LED
+    inline CRGB blend(const CRGB &a, const CRGB &b, uint8_t amount)
+    {
+        return CRGB(a.r + ((((int16_t) b.r - a.r) * amount) >> 8),
+                    a.g + ((((int16_t) b.g - a.g) * amount) >> 8),
+                    a.b + ((((int16_t) b.b - a.b) * amount) >> 8));
+    }
+
+    // A bar across the strip, drawn with one fill or a call per LED and
+    // composited. The moving cases shorten the bar by an LED a pass, the
+    // others redraw the same bar
+    void layerFill(bool bulk, bool changing, const char *label)
+    {
+        const uint32_t ops = 1000000;
+        const uint16_t n = LAYERS_MAX_LEDS;
+        CRGB color(0, 0, 255);
+        layers::reset();
+        result r = begin();
+        for (uint32_t i = 0; i < ops; i++) {
+            uint16_t first = changing ? (i % n) : 0;
+            layers::begin(layers::progress);
+            if (bulk) {
+#ifndef BENCH_NO_FILL
+                layers::fill(layers::progress, first, n, color);
+#endif
+            } else {
+                for (uint16_t j = first; j < n; j++) {
+                    layers::set(layers::progress, j, color);
+                }
+            }
+            layers::end(layers::progress);
+            layers::composite(leds);
+        }
+        end(label, r, ops);
+    }
+
+    // A two-color gradient across the strip, drawn with one fillGradient or
+    // a blended color per LED and composited
+    void layerGradient(bool bulk, const char *label)
+    {
+        const uint32_t ops = 1000000;
+        const uint16_t n = LAYERS_MAX_LEDS;
+        CRGB from(0, 255, 0);
+        CRGB to(255, 0, 0);
+        layers::reset();
+        result r = begin();
+        for (uint32_t i = 0; i < ops; i++) {
+            layers::begin(layers::progress);
+            if (bulk) {
+#ifndef BENCH_NO_FILL
+                layers::fillGradient(layers::progress, 0, n, from, to);
+#endif
+            } else {
+                for (uint16_t j = 0; j < n; j++) {
+                    layers::set(layers::progress, j, blend(from, to, (j * 255) / (n - 1)));
+                }
+            }
+            layers::end(layers::progress);
+            layers::composite(leds);
+        }
+        end(label, r, ops);
+    }
+
+    // Scales a color by factor / 256, as a mode without scaleRange would
+    // per LED
+    inline CRGB scale(const CRGB &c, uint8_t factor)
+    {
+        return CRGB((c.r * factor) >> 8, (c.g * factor) >> 8, (c.b * factor) >> 8);
+    }
+
+    // A pattern that scrolls up the strip by an LED a pass, moved with one
+    // copyRange or a set per LED from the top down, and composited
+    void layerCopy(bool bulk, const char *label)
+    {
+        const uint32_t ops = 1000000;
+        const uint16_t n = LAYERS_MAX_LEDS;
+        const CRGB *colors = layers::get().stack[layers::progress].colors;
+        layers::reset();
+        layers::begin(layers::progress);
+        for (uint16_t j = 0; j < n; j++) {
+            layers::set(layers::progress, j, CRGB(j * 8, 0, 255 - j * 8));
+        }
+        layers::end(layers::progress);
+        result r = begin();
+        for (uint32_t i = 0; i < ops; i++) {
+            CRGB top = colors[n - 1];
+            layers::begin(layers::progress);
+            if (bulk) {
+#ifndef BENCH_NO_COPY
+                layers::copyRange(layers::progress, 0, n - 1, 1);
+#endif
+            } else {
+                for (uint16_t j = n - 1; j > 0; j--) {
+                    layers::set(layers::progress, j, colors[j - 1]);
+                }
+            }
+            layers::set(layers::progress, 0, top);
+            layers::end(layers::progress);
+            layers::composite(leds);
+        }
+        end(label, r, ops);
+    }
+
+    // A bar dimmed by a factor that changes every pass, drawn with a fill
+    // and one scaleRange or with a scaled color per LED, and composited
+    void layerScale(bool bulk, const char *label)
+    {
+        const uint32_t ops = 1000000;
+        const uint16_t n = LAYERS_MAX_LEDS;
+        CRGB color(255, 50, 100);
+        layers::reset();
+        result r = begin();
+        for (uint32_t i = 0; i < ops; i++) {
+            uint8_t factor = 128 + (i & 0x7F);
+            layers::begin(layers::progress);
+            if (bulk) {
+#ifndef BENCH_NO_COPY
+                layers::fill(layers::progress, 0, n, color);
+                layers::scaleRange(layers::progress, 0, n, factor);
+#endif
+            } else {
+                for (uint16_t j = 0; j < n; j++) {
+                    layers::set(layers::progress, j, scale(color, factor));
+                }
+            }
+            layers::end(layers::progress);
+            layers::composite(leds);
+        }
+        end(label, r, ops);
+    }
+#endif
+}
+
+int main()
+{
+    init();
+    const char *runs = getenv("HOURGLASS_BENCH_RUNS");
+    for (int run = (runs != NULL) ? atoi(runs) : 5; run > 0; run--) {
+        bench::functionCopy();
+        bench::sharedPtrPass();
+        bench::listFolds();
+#ifndef BENCH_NO_BATCH
+        bench::batchCoalesce();
+#endif
+        bench::historyRecord();
+#ifndef BENCH_NO_HISTORY
+        bench::historyRing();
+#endif
+        bench::setting();
+        bench::timing();
+        bench::paused();
+        bench::finale();
+#ifdef LAYERS_H
+        bench::layerFill(false, false, "layers.set");
+        bench::layerFill(false, true, "layers.set.moving");
+        bench::layerGradient(false, "layers.set.gradient");
+#ifndef BENCH_NO_FILL
+        bench::layerFill(true, false, "layers.fill");
+        bench::layerFill(true, true, "layers.fill.moving");
+        bench::layerGradient(true, "layers.gradient");
+#endif
+        bench::layerCopy(false, "layers.set.copy");
+        bench::layerScale(false, "layers.set.scale");
+#ifndef BENCH_NO_COPY
+        bench::layerCopy(true, "layers.copy");
+        bench::layerScale(true, "layers.scale");
+#endif
+#endif
+    }
+    bench::print();
+    return 0;
+}
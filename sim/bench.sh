@@ -0,0 +1,51 @@
+#!/bin/sh
+# Builds sim/bench.cpp with optimisation and runs it. With no arguments it
+# benchmarks the working tree. Given git revisions, it benchmarks src/ and
+# lib/ as of each of them in turn, always with the stand-in headers in sim/
+# and the benchmark itself from the working tree, so a change can be
+# compared with its parent:
+#   sim/bench.sh HEAD~1 HEAD
+# Revisions before the simulator was added do not build on the host.
+# Run it from the repository root. The builds go to $OUT, .sim by default.
+set -e
+
+CXX=${CXX:-g++}
+OUT=${OUT:-.sim}
+
+mkdir -p "$OUT"
+
+# bench <tree> <binary>
+bench() {
+    FLAGS="-std=gnu++11 -O2 -w -I sim"
+    for dir in "$1"/lib/*/; do
+        FLAGS="$FLAGS -I $dir"
+    done
+    if ! grep -qs fillGradient "$1"/lib/Layers/Layers.h; then
+        FLAGS="$FLAGS -D BENCH_NO_FILL"
+    fi
+    if ! grep -qs copyRange "$1"/lib/Layers/Layers.h; then
+        FLAGS="$FLAGS -D BENCH_NO_COPY"
+    fi
+    if ! grep -qs ring_window "$1"/src/main.cpp; then
+        FLAGS="$FLAGS -D BENCH_NO_HISTORY"
+    fi
+    if ! grep -qs "total()" "$1"/src/main.cpp; then
+        FLAGS="$FLAGS -D BENCH_NO_BATCH"
+    fi
+    $CXX $FLAGS -D BENCH_MAIN="\"$PWD/$1/src/main.cpp\"" sim/bench.cpp -o "$2"
+    "$2"
+}
+
+if [ $# -eq 0 ]; then
+    bench . "$OUT/bench"
+    exit 0
+fi
+
+for rev in "$@"; do
+    tree="$OUT/bench-tree"
+    rm -rf "$tree"
+    mkdir -p "$tree"
+    git archive "$rev" src lib | tar -x -C "$tree"
+    echo "== $rev $(git log -1 --format=%s "$rev")"
+    bench "$tree" "$OUT/bench-rev"
+done
@@ -0,0 +1,61 @@
+#!/bin/sh
+# Builds src/main.cpp against the stand-in headers with the host compiler
+# and runs sim/modes.txt through it:
+#   - a -Wall build, printing the per-section statistics
+#   - sim/presses.txt through the same build, which must light three steps
+#   - an AddressSanitizer and UBSan build
+#   - the same with the block pool, the frame arena and an 8-bit reference
+#     count, which are opt-in
+#   - a build with -D HOURGLASS_NO_SLEEP, which must get to the end
+#   - a traced build that records the run and replays the recording, with a
+#     few bytes of garbage in front, which must capture the same frames
+# Run it from the repository root. The builds go to $OUT, .sim by default.
+set -e
+
+CXX=${CXX:-g++}
+OUT=${OUT:-.sim}
+SCRIPT=sim/modes.txt
+FLAGS="-std=gnu++11 -I sim"
+for dir in lib/*/; do
+    FLAGS="$FLAGS -I $dir"
+done
+
+mkdir -p "$OUT"
+
+echo "== modes"
+$CXX $FLAGS -O2 -Wall src/main.cpp -o "$OUT/hourglass"
+HOURGLASS_SIM_SCRIPT=$SCRIPT "$OUT/hourglass"
+
+echo "== presses"
+HOURGLASS_SIM_SCRIPT=sim/presses.txt HOURGLASS_SIM_CAPTURE="$OUT/presses.txt" "$OUT/hourglass" > /dev/null
+# The 15-second steps are pink, which the capture has in GRB order
+steps=$(tail -n 1 "$OUT/presses.txt" | tr ' ' '\n' | grep -c 32ff64 || true)
+if [ "$steps" != 3 ]; then
+    echo "expected 3 steps set, got $steps"
+    exit 1
+fi
+
+echo "== sanitizers"
+$CXX $FLAGS -O1 -g -fsanitize=address,undefined -fno-sanitize-recover=all -w src/main.cpp -o "$OUT/hourglass_asan"
+HOURGLASS_SIM_SCRIPT=$SCRIPT "$OUT/hourglass_asan" > /dev/null
+
+echo "== pool and arena"
+$CXX $FLAGS -O1 -g -fsanitize=address,undefined -fno-sanitize-recover=all -w \
+    -D JUNIPER_POOL_BLOCKS=8 -D JUNIPER_FRAME_ARENA_SIZE=128 -D JUNIPER_REF_COUNT_TYPE=uint8_t \
+    src/main.cpp -o "$OUT/hourglass_pool"
+HOURGLASS_SIM_SCRIPT=$SCRIPT "$OUT/hourglass_pool" > /dev/null
+
+echo "== no sleep"
+$CXX $FLAGS -O1 -w -D HOURGLASS_NO_SLEEP src/main.cpp -o "$OUT/hourglass_nosleep"
+HOURGLASS_SIM_SCRIPT=$SCRIPT HOURGLASS_SIM_FRAMES=100000 timeout 60 "$OUT/hourglass_nosleep"
+
+echo "== trace replay"
+$CXX $FLAGS -O1 -w -D HOURGLASS_TRACE src/main.cpp -o "$OUT/hourglass_trace"
+HOURGLASS_SIM_SCRIPT=$SCRIPT HOURGLASS_SIM_CAPTURE="$OUT/recorded.txt" HOURGLASS_SIM_TRACE="$OUT/run.trace" \
+    "$OUT/hourglass_trace" > /dev/null
+( printf '\022\064\245'; cat "$OUT/run.trace" ) > "$OUT/shifted.trace"
+HOURGLASS_SIM_REPLAY="$OUT/shifted.trace" HOURGLASS_SIM_CAPTURE="$OUT/replayed.txt" \
+    "$OUT/hourglass_trace" > /dev/null
+cmp "$OUT/recorded.txt" "$OUT/replayed.txt"
+
+echo "ok"
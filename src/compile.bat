@@ -1 +0,0 @@
-Juniper.exe -s FastLed.jun Accelerometer.jun IoExt.jun SignalExt.jun Constants.jun Timing.jun Setting.jun Paused.jun Finale.jun Program.jun -o main.cpp
@@ -6,13 +6,453 @@
 
 #include <stdlib.h>
 
+// Closures up to this many bytes (including the vtable pointer) are stored
+// inside juniper::function itself instead of on the heap.
+#ifndef JUNIPER_FUNCTION_INLINE_SIZE
+#define JUNIPER_FUNCTION_INLINE_SIZE (6 * sizeof(void *))
+#endif
+
+namespace juniper
+{
+    struct inplace_t {};
+
+    template<typename T> struct remove_reference { typedef T type; };
+    template<typename T> struct remove_reference<T &> { typedef T type; };
+    template<typename T> struct remove_reference<T &&> { typedef T type; };
+
+    template<typename T> struct remove_const { typedef T type; };
+    template<typename T> struct remove_const<const T> { typedef T type; };
+
+    template<typename T>
+    struct decay
+    {
+        typedef typename remove_const<typename remove_reference<T>::type>::type type;
+    };
+
+    template<typename T, typename U> struct is_same { static const bool value = false; };
+    template<typename T> struct is_same<T, T> { static const bool value = true; };
+
+    template<bool Cond, typename T = void> struct enable_if {};
+    template<typename T> struct enable_if<true, T> { typedef T type; };
+
+    template<typename T>
+    typename remove_reference<T>::type &&move(T &&x)
+    {
+        return static_cast<typename remove_reference<T>::type &&>(x);
+    }
+
+    template<typename T>
+    T &&forward(typename remove_reference<T>::type &x)
+    {
+        return static_cast<T &&>(x);
+    }
+
+    template<typename T>
+    T &&forward(typename remove_reference<T>::type &&x)
+    {
+        return static_cast<T &&>(x);
+    }
+}
+
+inline void *operator new(size_t, juniper::inplace_t, void *where)
+{
+    return where;
+}
+
+inline void operator delete(void *, juniper::inplace_t, void *)
+{}
+
+// Runtime allocations (closures that do not fit inline and shared_ptr
+// control blocks) go through juniper::allocate. Defining JUNIPER_POOL_BLOCKS
+// serves them from a static pool of that many JUNIPER_POOL_BLOCK_SIZE byte
+// blocks, falling back to the heap only when a request is too large or the
+// pool is exhausted. Defining JUNIPER_FRAME_ARENA_SIZE additionally serves
+// allocations made between frame_begin() and frame_end() from a bump arena
+// that is reset at the end of every frame.
+#ifndef JUNIPER_POOL_BLOCK_SIZE
+#define JUNIPER_POOL_BLOCK_SIZE (8 * sizeof(void *))
+#endif
+
+namespace juniper
+{
+    union max_align_t {
+        void *p;
+        double d;
+        long l;
+    };
+
+    struct pool_stats {
+        size_t blocks_in_use;
+        size_t peak_blocks;
+        size_t overflows;
+        size_t arena_peak;
+    };
+
+    namespace detail
+    {
+        inline pool_stats &stats()
+        {
+            static pool_stats s = { 0, 0, 0, 0 };
+            return s;
+        }
+
+#ifdef JUNIPER_POOL_BLOCKS
+        union pool_block {
+            pool_block *next;
+            max_align_t align;
+            unsigned char bytes[JUNIPER_POOL_BLOCK_SIZE];
+        };
+
+        struct pool {
+            pool_block blocks[JUNIPER_POOL_BLOCKS];
+            pool_block *free_list;
+
+            pool()
+                : free_list(nullptr)
+            {
+                for (size_t i = JUNIPER_POOL_BLOCKS; i > 0; i--) {
+                    blocks[i - 1].next = free_list;
+                    free_list = &blocks[i - 1];
+                }
+            }
+
+            bool owns(void *ptr) const
+            {
+                return (ptr >= (const void *) blocks) && (ptr < (const void *) (blocks + JUNIPER_POOL_BLOCKS));
+            }
+        };
+
+        inline pool &block_pool()
+        {
+            static pool p;
+            return p;
+        }
+#endif
+
+#ifdef JUNIPER_FRAME_ARENA_SIZE
+        struct arena {
+            union {
+                max_align_t align;
+                unsigned char bytes[JUNIPER_FRAME_ARENA_SIZE];
+            } storage;
+            size_t used;
+            size_t live;
+            bool active;
+
+            bool owns(void *ptr) const
+            {
+                return (ptr >= (const void *) storage.bytes) && (ptr < (const void *) (storage.bytes + JUNIPER_FRAME_ARENA_SIZE));
+            }
+        };
+
+        inline arena &frame_arena()
+        {
+            static arena a = {};
+            return a;
+        }
+#endif
+    }
+
+    inline void *allocate(size_t size)
+    {
+#ifdef JUNIPER_FRAME_ARENA_SIZE
+        detail::arena &a = detail::frame_arena();
+        size_t rounded = (size + sizeof(max_align_t) - 1) / sizeof(max_align_t) * sizeof(max_align_t);
+        if (a.active && (rounded <= JUNIPER_FRAME_ARENA_SIZE - a.used)) {
+            void *ret = a.storage.bytes + a.used;
+            a.used += rounded;
+            a.live++;
+            if (a.used > detail::stats().arena_peak)
+                detail::stats().arena_peak = a.used;
+            return ret;
+        }
+#endif
+#ifdef JUNIPER_POOL_BLOCKS
+        detail::pool &p = detail::block_pool();
+        if ((size <= sizeof(detail::pool_block)) && p.free_list) {
+            detail::pool_block *block = p.free_list;
+            p.free_list = block->next;
+            pool_stats &s = detail::stats();
+            s.blocks_in_use++;
+            if (s.blocks_in_use > s.peak_blocks)
+                s.peak_blocks = s.blocks_in_use;
+            return block;
+        }
+        detail::stats().overflows++;
+#endif
+        return ::operator new(size);
+    }
+
+    inline void deallocate(void *ptr)
+    {
+#ifdef JUNIPER_FRAME_ARENA_SIZE
+        detail::arena &a = detail::frame_arena();
+        if (a.owns(ptr)) {
+            a.live--;
+            return;
+        }
+#endif
+#ifdef JUNIPER_POOL_BLOCKS
+        detail::pool &p = detail::block_pool();
+        if (p.owns(ptr)) {
+            detail::pool_block *block = (detail::pool_block *) ptr;
+            block->next = p.free_list;
+            p.free_list = block;
+            detail::stats().blocks_in_use--;
+            return;
+        }
+#endif
+        ::operator delete(ptr);
+    }
+
+    // Marks the start of a frame. Allocations made until frame_end() come
+    // from the frame arena when one is configured.
+    inline void frame_begin()
+    {
+#ifdef JUNIPER_FRAME_ARENA_SIZE
+        detail::frame_arena().active = true;
+#endif
+    }
+
+    // Marks the end of a frame. The arena is rewound once every allocation
+    // made from it has been released, so a closure that outlives its frame
+    // keeps its memory until it is destroyed.
+    inline void frame_end()
+    {
+#ifdef JUNIPER_FRAME_ARENA_SIZE
+        detail::arena &a = detail::frame_arena();
+        a.active = false;
+        if (a.live == 0)
+            a.used = 0;
+#endif
+    }
+
+    // Current and peak usage of the pool and the frame arena, for sizing
+    // JUNIPER_POOL_BLOCKS and JUNIPER_FRAME_ARENA_SIZE.
+    inline pool_stats pool_usage()
+    {
+        return detail::stats();
+    }
+
+    // Mixed into runtime types so that new and delete on them go through
+    // juniper::allocate and juniper::deallocate.
+    struct pool_allocated
+    {
+        static void *operator new(size_t size)
+        {
+            return allocate(size);
+        }
+        static void *operator new(size_t, inplace_t, void *where)
+        {
+            return where;
+        }
+        static void operator delete(void *ptr)
+        {
+            deallocate(ptr);
+        }
+        static void operator delete(void *, inplace_t, void *)
+        {}
+    };
+}
+
+// Timers in the standard library report when they next need the program to
+// run through juniper::wake_at. A program that sleeps between frames collects
+// the earliest request with juniper::take_wake and sleeps no longer than that.
+namespace juniper
+{
+    namespace detail
+    {
+        struct wake_request {
+            bool pending;
+            uint32_t at;
+        };
+
+        inline wake_request &wake()
+        {
+            static wake_request w = { false, 0 };
+            return w;
+        }
+    }
+
+    // Asks for the program to run again no later than the millisecond
+    // timestamp at. The earliest request wins until it is taken.
+    inline void wake_at(uint32_t at)
+    {
+        detail::wake_request &w = detail::wake();
+        if (!w.pending || ((int32_t) (at - w.at) < 0)) {
+            w.pending = true;
+            w.at = at;
+        }
+    }
+
+    // Returns whether a wake was requested since the last call, storing its
+    // time in at, and clears the request.
+    inline bool take_wake(uint32_t &at)
+    {
+        detail::wake_request &w = detail::wake();
+        bool pending = w.pending;
+        at = w.at;
+        w.pending = false;
+        return pending;
+    }
+}
+
+#ifndef JUNIPER_MAX_TIMERS
+#define JUNIPER_MAX_TIMERS 8
+#endif
+
+// Time::every subscribes its state to a central timer service, and
+// Time::cancel unsubscribes it. The service keeps the subscribed timers in a
+// binary min-heap ordered by their next deadline, so a frame in which nothing
+// is due costs one comparison against the top of the heap. Deadlines fall on
+// multiples of the interval, as they did when every divided the clock, but
+// move on by addition, so a timer only divides when it subscribes or falls
+// behind.
+namespace juniper
+{
+    namespace detail
+    {
+        struct timer {
+            uint32_t deadline;
+            uint32_t interval;
+            bool fired;
+            bool used;
+        };
+
+        struct timer_heap {
+            timer timers[JUNIPER_MAX_TIMERS];
+            // Indices into timers, ordered as a heap on their deadlines
+            uint8_t order[JUNIPER_MAX_TIMERS];
+            uint8_t count;
+        };
+
+        inline timer_heap &timers()
+        {
+            static timer_heap h = {};
+            return h;
+        }
+
+        inline bool timer_before(const timer_heap &h, uint8_t a, uint8_t b)
+        {
+            return (int32_t) (h.timers[h.order[a]].deadline - h.timers[h.order[b]].deadline) < 0;
+        }
+
+        inline void timer_swap(timer_heap &h, uint8_t a, uint8_t b)
+        {
+            uint8_t tmp = h.order[a];
+            h.order[a] = h.order[b];
+            h.order[b] = tmp;
+        }
+
+        inline void timer_sift_up(timer_heap &h, uint8_t i)
+        {
+            while (i > 0) {
+                uint8_t parent = (i - 1) / 2;
+                if (!timer_before(h, i, parent))
+                    break;
+                timer_swap(h, i, parent);
+                i = parent;
+            }
+        }
+
+        inline void timer_sift_down(timer_heap &h, uint8_t i)
+        {
+            for (;;) {
+                uint8_t smallest = i;
+                uint8_t left = 2 * i + 1;
+                uint8_t right = left + 1;
+                if (left < h.count && timer_before(h, left, smallest))
+                    smallest = left;
+                if (right < h.count && timer_before(h, right, smallest))
+                    smallest = right;
+                if (smallest == i)
+                    break;
+                timer_swap(h, i, smallest);
+                i = smallest;
+            }
+        }
+    }
+
+    // Subscribes a timer that fires at every multiple of interval
+    // milliseconds, and at once if now is past the first. Returns its id, or
+    // 0 if all JUNIPER_MAX_TIMERS are taken.
+    inline uint8_t timer_subscribe(uint32_t interval, uint32_t now)
+    {
+        detail::timer_heap &h = detail::timers();
+        if (h.count == JUNIPER_MAX_TIMERS)
+            return 0;
+        uint8_t index = 0;
+        while (h.timers[index].used)
+            index++;
+        detail::timer &t = h.timers[index];
+        t.interval = interval == 0 ? 1 : interval;
+        t.deadline = (now / t.interval + 1) * t.interval;
+        t.fired = now >= t.interval;
+        t.used = true;
+        h.order[h.count] = index;
+        h.count++;
+        detail::timer_sift_up(h, h.count - 1);
+        return index + 1;
+    }
+
+    // Stops the timer with the given id and frees it for another subscriber
+    inline void timer_unsubscribe(uint8_t id)
+    {
+        detail::timer_heap &h = detail::timers();
+        uint8_t i = 0;
+        while (h.order[i] != id - 1)
+            i++;
+        h.timers[id - 1].used = false;
+        h.count--;
+        if (i != h.count) {
+            h.order[i] = h.order[h.count];
+            detail::timer_sift_down(h, i);
+            detail::timer_sift_up(h, i);
+        }
+    }
+
+    // Marks the timers whose deadline has passed as fired and moves their
+    // deadlines on. A timer that fell more than one interval behind fires
+    // once and skips to the first multiple of its interval after now.
+    // Requests a wake for the next deadline.
+    inline void timer_poll(uint32_t now)
+    {
+        detail::timer_heap &h = detail::timers();
+        if (h.count == 0)
+            return;
+        for (;;) {
+            detail::timer &t = h.timers[h.order[0]];
+            if ((int32_t) (t.deadline - now) > 0)
+                break;
+            t.fired = true;
+            t.deadline += t.interval;
+            if ((int32_t) (t.deadline - now) <= 0)
+                t.deadline += ((now - t.deadline) / t.interval + 1) * t.interval;
+            detail::timer_sift_down(h, 0);
+        }
+        wake_at(h.timers[h.order[0]].deadline);
+    }
+
+    // Returns whether the timer with the given id fired since the last call,
+    // and clears it.
+    inline bool timer_take(uint8_t id)
+    {
+        detail::timer &t = detail::timers().timers[id - 1];
+        bool fired = t.fired;
+        t.fired = false;
+        return fired;
+    }
+}
+
 namespace juniper
 {
     template<typename Result, typename ...Args>
-    struct abstract_function
+    struct abstract_function : pool_allocated
     {
         virtual Result operator()(Args... args) = 0;
         virtual abstract_function *clone() const = 0;
+        virtual abstract_function *clone_into(void *buffer) const = 0;
+        virtual abstract_function *move_into(void *buffer) = 0;
         virtual ~abstract_function() = default;
     };
 
@@ -24,6 +464,9 @@ namespace juniper
         concrete_function(const Func &x)
             : f(x)
         {}
+        concrete_function(Func &&x)
+            : f(juniper::move(x))
+        {}
         Result operator()(Args... args) override
         {
             return f(args...);
@@ -32,6 +475,14 @@ namespace juniper
         {
             return new concrete_function{ f };
         }
+        concrete_function *clone_into(void *buffer) const override
+        {
+            return new (inplace_t(), buffer) concrete_function{ f };
+        }
+        concrete_function *move_into(void *buffer) override
+        {
+            return new (inplace_t(), buffer) concrete_function{ juniper::move(f) };
+        }
     };
 
     template<typename Func>
@@ -52,31 +503,94 @@ namespace juniper
     class function<Result(Args...)>
     {
         abstract_function<Result, Args...> *f;
+        union {
+            void *align_ptr;
+            double align_double;
+            unsigned char buffer[JUNIPER_FUNCTION_INLINE_SIZE];
+        } storage;
+
+        bool is_inline() const
+        {
+            return (const void *) f == (const void *) storage.buffer;
+        }
+        template<typename Func> void assign(Func &&x)
+        {
+            typedef concrete_function<typename func_filter<typename decay<Func>::type>::type, Result, Args...> concrete;
+            if ((sizeof(concrete) <= sizeof(storage)) && (alignof(concrete) <= alignof(decltype(storage))))
+                f = new (inplace_t(), storage.buffer) concrete(juniper::forward<Func>(x));
+            else
+                f = new concrete(juniper::forward<Func>(x));
+        }
+        void assign(const function &rhs)
+        {
+            if (!rhs.f)
+                f = nullptr;
+            else if (rhs.is_inline())
+                f = rhs.f->clone_into(storage.buffer);
+            else
+                f = rhs.f->clone();
+        }
+        void take(function &rhs)
+        {
+            if (rhs.is_inline())
+            {
+                f = rhs.f->move_into(storage.buffer);
+                rhs.release();
+            }
+            else
+            {
+                f = rhs.f;
+                rhs.f = nullptr;
+            }
+        }
+        void release()
+        {
+            if (is_inline())
+                f->~abstract_function();
+            else
+                delete f;
+            f = nullptr;
+        }
     public:
         function()
             : f(nullptr)
         {}
-        template<typename Func> function(const Func &x)
-            : f(new concrete_function<typename func_filter<Func>::type, Result, Args...>(x))
-        {}
+        template<typename Func, typename = typename enable_if<!is_same<typename decay<Func>::type, function>::value>::type>
+        function(Func &&x)
+        {
+            assign(juniper::forward<Func>(x));
+        }
         function(const function &rhs)
-            : f(rhs.f ? rhs.f->clone() : nullptr)
-        {}
+        {
+            assign(rhs);
+        }
+        function(function &&rhs)
+        {
+            take(rhs);
+        }
         function &operator=(const function &rhs)
         {
             if ((&rhs != this) && (rhs.f))
             {
-                auto *temp = rhs.f->clone();
-                delete f;
-                f = temp;
+                release();
+                assign(rhs);
+            }
+            return *this;
+        }
+        function &operator=(function &&rhs)
+        {
+            if (&rhs != this)
+            {
+                release();
+                take(rhs);
             }
             return *this;
         }
-        template<typename Func> function &operator=(const Func &x)
+        template<typename Func, typename = typename enable_if<!is_same<typename decay<Func>::type, function>::value>::type>
+        function &operator=(Func &&x)
         {
-            auto *temp = new concrete_function<typename func_filter<Func>::type, Result, Args...>(x);
-            delete f;
-            f = temp;
+            release();
+            assign(juniper::forward<Func>(x));
             return *this;
         }
         Result operator()(Args... args)
@@ -88,41 +602,144 @@ namespace juniper
         }
         ~function()
         {
-            delete f;
+            release();
+        }
+    };
+
+    // Non-owning reference to a callable. It must not outlive the callable it
+    // was built from, so it is only used for callbacks that do not escape the
+    // call they are passed to. Calling through it needs no allocation and no
+    // virtual dispatch.
+    template<typename signature>
+    class function_ref;
+
+    template<typename Result, typename ...Args>
+    class function_ref<Result(Args...)>
+    {
+        union target_t {
+            void *obj;
+            Result (*fp)(Args...);
+            void (*other_fp)();
+        } target;
+        Result (*callback)(target_t, Args...);
+
+        template<typename Func>
+        static Result call_object(target_t t, Args... args)
+        {
+            return (*static_cast<Func *>(t.obj))(args...);
+        }
+        static Result call_pointer(target_t t, Args... args)
+        {
+            return t.fp(args...);
+        }
+        template<typename OtherResult, typename ...OtherArgs>
+        static Result call_other_pointer(target_t t, Args... args)
+        {
+            return reinterpret_cast<OtherResult (*)(OtherArgs...)>(t.other_fp)(args...);
+        }
+    public:
+        function_ref(Result (*fp)(Args...))
+            : callback(&call_pointer)
+        {
+            target.fp = fp;
+        }
+        // A function whose parameters differ from Args but accept them, for
+        // example one taking const T& where Args has T
+        template<typename OtherResult, typename ...OtherArgs>
+        function_ref(OtherResult (&fn)(OtherArgs...))
+            : callback(&call_other_pointer<OtherResult, OtherArgs...>)
+        {
+            target.other_fp = reinterpret_cast<void (*)()>(&fn);
+        }
+        template<typename Func, typename = typename enable_if<!is_same<typename decay<Func>::type, function_ref>::value>::type>
+        function_ref(Func &&x)
+            : callback(&call_object<typename remove_reference<Func>::type>)
+        {
+            target.obj = (void *) &x;
+        }
+        Result operator()(Args... args) const
+        {
+            return callback(target, args...);
         }
     };
 
     template <class T>
     void swap(T& a, T& b) {
-        T c(a);
-        a = b;
-        b = c;
+        T c(juniper::move(a));
+        a = juniper::move(b);
+        b = juniper::move(c);
     }
 
+    // Reference count type used by shared_ptr. On AVR, define this as
+    // uint8_t to save a byte per ref cell. A count that reaches the largest
+    // value of the type stays there, so an object shared by that many
+    // references is leaked rather than freed while still in use.
+#ifndef JUNIPER_REF_COUNT_TYPE
+#define JUNIPER_REF_COUNT_TYPE int
+#endif
+
+    typedef JUNIPER_REF_COUNT_TYPE ref_count_t;
+
+    const ref_count_t ref_count_max = ((ref_count_t) -1 > 0)
+        ? (ref_count_t) -1
+        : (ref_count_t) ((1UL << (sizeof(ref_count_t) * 8 - 1)) - 1);
+
+    // Control block shared by every shared_ptr pointing at the same object.
+    // destroy frees the object and the block once the count drops to zero.
+    struct ref_block : pool_allocated {
+        ref_count_t count;
+        void (*destroy)(ref_block *block, void *ptr);
+    };
+
+    // Control block and object in a single allocation, see make_shared.
+    template <typename contained>
+    struct shared_block : ref_block {
+        contained value;
+
+        template <typename ...Args>
+        shared_block(Args&&... args)
+            : value(juniper::forward<Args>(args)...)
+        {}
+    };
+
+    template <typename contained>
+    class shared_ptr;
+
+    template <typename contained, typename ...Args>
+    shared_ptr<contained> make_shared(Args&&... args);
+
+    template <typename contained>
+    class static_ref;
+
     template <typename contained>
     class shared_ptr {
     public:
-        shared_ptr() : ptr_(NULL), ref_count_(NULL) { }
+        shared_ptr() : ptr_(NULL), block_(NULL) { }
 
         shared_ptr(contained * p)
-            : ptr_(p), ref_count_(new int)
+            : ptr_(p), block_(new ref_block)
         {
-            *ref_count_ = 0;
+            block_->count = 0;
+            block_->destroy = &destroy_separate;
             inc_ref();
         }
 
         shared_ptr(const shared_ptr& rhs)
-            : ptr_(rhs.ptr_), ref_count_(rhs.ref_count_)
+            : ptr_(rhs.ptr_), block_(rhs.block_)
         {
             inc_ref();
         }
 
+        shared_ptr(shared_ptr&& rhs)
+            : ptr_(rhs.ptr_), block_(rhs.block_)
+        {
+            rhs.ptr_ = NULL;
+            rhs.block_ = NULL;
+        }
+
         ~shared_ptr() {
-            if (ref_count_ && 0 == dec_ref()) {
-                if (ptr_) {
-                    delete ptr_;
-                }
-                delete ref_count_;
+            if (block_ && 0 == dec_ref()) {
+                block_->destroy(block_, (void *) ptr_);
             }
         }
 
@@ -135,7 +752,7 @@ namespace juniper
 
         void swap(shared_ptr& rhs) {
             juniper::swap(ptr_, rhs.ptr_);
-            juniper::swap(ref_count_, rhs.ref_count_);
+            juniper::swap(block_, rhs.block_);
         }
 
         shared_ptr& operator=(const shared_ptr& rhs) {
@@ -144,6 +761,12 @@ namespace juniper
             return *this;
         }
 
+        shared_ptr& operator=(shared_ptr&& rhs) {
+            shared_ptr tmp(juniper::move(rhs));
+            this->swap(tmp);
+            return *this;
+        }
+
         //contained& operator*() {
         //    return *ptr_;
         //}
@@ -152,30 +775,93 @@ namespace juniper
             return ptr_;
         }
 
-        bool operator==(shared_ptr& rhs) {
+        bool operator==(const shared_ptr& rhs) const {
             return ptr_ == rhs.ptr_;
         }
 
-        bool operator!=(shared_ptr& rhs) { return !(rhs == *this); }
+        bool operator!=(const shared_ptr& rhs) const { return !(rhs == *this); }
     private:
+        template <typename T, typename ...Args>
+        friend shared_ptr<T> make_shared(Args&&... args);
+
+        template <typename T>
+        friend class static_ref;
+
+        static void destroy_separate(ref_block *block, void *ptr) {
+            if (ptr) {
+                delete (contained *) ptr;
+            }
+            delete block;
+        }
+
+        static void destroy_combined(ref_block *block, void *) {
+            delete static_cast<shared_block<contained> *>(block);
+        }
+
         void inc_ref() {
-            if (ref_count_) {
-                ++(*ref_count_);
+            if (block_ && block_->count != ref_count_max) {
+                ++(block_->count);
             }
         }
 
-        int dec_ref() {
-            return --(*ref_count_);
+        ref_count_t dec_ref() {
+            if (block_->count == ref_count_max) {
+                return ref_count_max;
+            }
+            return --(block_->count);
         }
 
         contained * ptr_;
-        int * ref_count_;
+        ref_block * block_;
     };
 
-    template<typename T, size_t N>
-    class array {
+    // Allocates the object and its reference count together, halving the
+    // number of heap blocks compared to shared_ptr(new contained(...)).
+    template <typename contained, typename ...Args>
+    shared_ptr<contained> make_shared(Args&&... args) {
+        shared_block<contained> *block = new shared_block<contained>(juniper::forward<Args>(args)...);
+        block->count = 1;
+        block->destroy = &shared_ptr<contained>::destroy_combined;
+        shared_ptr<contained> ret;
+        ret.ptr_ = &block->value;
+        ret.block_ = block;
+        return ret;
+    }
+
+    // Storage for a module-level ref. The value lives in static storage for
+    // the whole program, so it needs no heap block and no reference count.
+    // It converts to a shared_ptr without a control block, which copies and
+    // destroys without touching any count.
+    template <typename contained>
+    class static_ref {
+    public:
+        static_ref(const contained& initial)
+            : value_(initial)
+        {}
+
+        contained* get() { return &value_; }
+        const contained* get() const { return &value_; }
+
+        contained* operator->() {
+            return &value_;
+        }
+
+        operator shared_ptr<contained>() {
+            shared_ptr<contained> ret;
+            ret.ptr_ = &value_;
+            return ret;
+        }
+    private:
+        contained value_;
+    };
+
+    // array is kept an aggregate so that brace initialization keeps working.
+    // Its implicitly declared move constructor and move assignment move each
+    // element in turn.
+    template<typename T, size_t N>
+    class array {
     public:
-        array<T, N>& fill(T fillWith) {
+        array<T, N>& fill(const T& fillWith) {
             for (size_t i = 0; i < N; i++) {
                 data[i] = fillWith;
             }
@@ -187,7 +873,11 @@ namespace juniper
             return data[i];
         }
 
-        bool operator==(array<T, N>& rhs) {
+        const T& operator[](int i) const {
+            return data[i];
+        }
+
+        bool operator==(const array<T, N>& rhs) const {
             for (auto i = 0; i < N; i++) {
                 if (data[i] != rhs[i]) {
                     return false;
@@ -196,11 +886,171 @@ namespace juniper
             return true;
         }
 
-        bool operator!=(array<T, N>& rhs) { return !(rhs == *this); }
+        bool operator!=(const array<T, N>& rhs) const { return !(rhs == *this); }
 
         T data[N];
     };
 
+    template<typename T, int N>
+    class ring;
+
+    // A read-only view of the newest values held by a ring. Element 0 is the
+    // newest. The view is two words, so it is cheap to pass around in a
+    // signal, and it stays valid for as long as the ring does.
+    template<typename T, int N>
+    class ring_window {
+    public:
+        class const_iterator {
+        public:
+            const_iterator(const ring<T, N> *source, uint32_t index)
+                : source_(source), index_(index)
+            {}
+
+            const T& operator*() const {
+                return (*source_)[index_];
+            }
+
+            const_iterator& operator++() {
+                index_++;
+                return *this;
+            }
+
+            bool operator!=(const const_iterator& rhs) const { return index_ != rhs.index_; }
+        private:
+            const ring<T, N> *source_;
+            uint32_t index_;
+        };
+
+        // Trivial, so that a window can sit in the union of a maybe
+        ring_window() = default;
+
+        ring_window(const ring<T, N> *source, uint32_t length)
+            : source_(source), length_(length)
+        {}
+
+        const T& operator[](uint32_t i) const {
+            return (*source_)[i];
+        }
+
+        uint32_t length() const { return length_; }
+
+        const_iterator begin() const { return const_iterator(source_, 0); }
+        const_iterator end() const { return const_iterator(source_, length_); }
+    private:
+        const ring<T, N> *source_;
+        uint32_t length_;
+    };
+
+    // Fixed capacity history with O(1) insertion. Once full, each push
+    // overwrites the oldest value instead of shifting the others along.
+    template<typename T, int N>
+    class ring {
+    public:
+        ring()
+            : head_(0), length_(0)
+        {}
+
+        void push(const T& value) {
+            head_ = (head_ + 1 == N) ? 0 : head_ + 1;
+            data_[head_] = value;
+            if (length_ < N) {
+                length_++;
+            }
+        }
+
+        // Element 0 is the newest and element length() - 1 the oldest
+        const T& operator[](uint32_t i) const {
+            return data_[(head_ >= i) ? (head_ - i) : (head_ + N - i)];
+        }
+
+        uint32_t length() const { return length_; }
+
+        ring_window<T, N> window(uint32_t count) const {
+            return ring_window<T, N>(this, (count < length_) ? count : length_);
+        }
+
+        ring_window<T, N> all() const {
+            return ring_window<T, N>(this, length_);
+        }
+    private:
+        T data_[N];
+        uint32_t head_;
+        uint32_t length_;
+    };
+
+    // A value together with a generation that counts the changes made to
+    // it. A reader remembers the generation it last saw and can skip its
+    // work until the generation moves on. Generations start at 1, so a
+    // reader that has seen 0 always runs.
+    template<typename T>
+    struct tracked {
+        T value;
+        uint32_t generation;
+    };
+
+    // A read-only view of slots that a signal updates in place, such as the
+    // latest inputs kept by Signal::holdLatest. Passing the view along a
+    // signal copies a pointer rather than the slots. It stays valid for as
+    // long as the slots do.
+    template<typename T>
+    class slots_view {
+    public:
+        // Trivial, so that a view can sit in the union of a maybe
+        slots_view() = default;
+
+        explicit slots_view(const tracked<T> *slots)
+            : slots_(slots)
+        {}
+
+        const T& operator*() const { return slots_->value; }
+        const T* operator->() const { return &slots_->value; }
+
+        uint32_t generation() const { return slots_->generation; }
+    private:
+        const tracked<T> *slots_;
+    };
+
+    // The events that arrived during one tick, oldest first, so that a
+    // signal can carry more than one per tick. At most N are kept. Once
+    // full, each further event replaces the newest one kept, so the latest
+    // event is never lost, and total() still counts every event.
+    template<typename T, int N>
+    class batch {
+    public:
+        // Trivial, so that a batch can sit in the union of a maybe
+        batch() = default;
+
+        static batch<T, N> empty() {
+            batch<T, N> b;
+            b.length_ = 0;
+            b.total_ = 0;
+            return b;
+        }
+
+        void push(const T& event) {
+            if (length_ < N) {
+                length_++;
+            }
+            events_[length_ - 1] = event;
+            if (total_ < 0xFFFF) {
+                total_++;
+            }
+        }
+
+        const T& operator[](uint8_t i) const { return events_[i]; }
+        const T& latest() const { return events_[length_ - 1]; }
+
+        uint8_t length() const { return length_; }
+        uint16_t total() const { return total_; }
+
+        const T* begin() const { return events_; }
+        const T* end() const { return events_ + length_; }
+    private:
+        T events_[N];
+        uint8_t length_;
+        uint16_t total_;
+    };
+
     template<typename T>
     T quit() {
         exit(1);
@@ -211,6 +1061,13 @@ namespace juniper
 
 #include <Arduino.h>
 #include <FastLED.h>
+#include <Strip.h>
+#include <ColorMath.h>
+#include <Layers.h>
+#include <EdgeCapture.h>
+#include <Profiler.h>
+#include <Scheduler.h>
+#include <Trace.h>
 
 namespace Prelude {}
 namespace List {}
@@ -345,11 +1202,11 @@ namespace Program {
 
 namespace Prelude {
     struct unit {
-        bool operator==(unit rhs) {
+        bool operator==(const unit& rhs) const {
             return true;
         }
 
-        bool operator!=(unit rhs) {
+        bool operator!=(const unit& rhs) const {
             return !(rhs == *this);
         }
     };
@@ -360,11 +1217,11 @@ namespace Prelude {
     struct tuple2 {
         a e1;
         b e2;
-        bool operator==(tuple2 rhs) {
+        bool operator==(const tuple2& rhs) const {
             return true && e1 == rhs.e1 && e2 == rhs.e2;
         }
 
-        bool operator!=(tuple2 rhs) {
+        bool operator!=(const tuple2& rhs) const {
             return !(rhs == *this);
         }
     };
@@ -376,11 +1233,11 @@ namespace Prelude {
         a e1;
         b e2;
         c e3;
-        bool operator==(tuple3 rhs) {
+        bool operator==(const tuple3& rhs) const {
             return true && e1 == rhs.e1 && e2 == rhs.e2 && e3 == rhs.e3;
         }
 
-        bool operator!=(tuple3 rhs) {
+        bool operator!=(const tuple3& rhs) const {
             return !(rhs == *this);
         }
     };
@@ -393,11 +1250,11 @@ namespace Prelude {
         b e2;
         c e3;
         d e4;
-        bool operator==(tuple4 rhs) {
+        bool operator==(const tuple4& rhs) const {
             return true && e1 == rhs.e1 && e2 == rhs.e2 && e3 == rhs.e3 && e4 == rhs.e4;
         }
 
-        bool operator!=(tuple4 rhs) {
+        bool operator!=(const tuple4& rhs) const {
             return !(rhs == *this);
         }
     };
@@ -411,11 +1268,11 @@ namespace Prelude {
         c e3;
         d e4;
         e e5;
-        bool operator==(tuple5 rhs) {
+        bool operator==(const tuple5& rhs) const {
             return true && e1 == rhs.e1 && e2 == rhs.e2 && e3 == rhs.e3 && e4 == rhs.e4 && e5 == rhs.e5;
         }
 
-        bool operator!=(tuple5 rhs) {
+        bool operator!=(const tuple5& rhs) const {
             return !(rhs == *this);
         }
     };
@@ -430,11 +1287,11 @@ namespace Prelude {
         d e4;
         e e5;
         f e6;
-        bool operator==(tuple6 rhs) {
+        bool operator==(const tuple6& rhs) const {
             return true && e1 == rhs.e1 && e2 == rhs.e2 && e3 == rhs.e3 && e4 == rhs.e4 && e5 == rhs.e5 && e6 == rhs.e6;
         }
 
-        bool operator!=(tuple6 rhs) {
+        bool operator!=(const tuple6& rhs) const {
             return !(rhs == *this);
         }
     };
@@ -450,11 +1307,11 @@ namespace Prelude {
         e e5;
         f e6;
         g e7;
-        bool operator==(tuple7 rhs) {
+        bool operator==(const tuple7& rhs) const {
             return true && e1 == rhs.e1 && e2 == rhs.e2 && e3 == rhs.e3 && e4 == rhs.e4 && e5 == rhs.e5 && e6 == rhs.e6 && e7 == rhs.e7;
         }
 
-        bool operator!=(tuple7 rhs) {
+        bool operator!=(const tuple7& rhs) const {
             return !(rhs == *this);
         }
     };
@@ -471,11 +1328,11 @@ namespace Prelude {
         f e6;
         g e7;
         h e8;
-        bool operator==(tuple8 rhs) {
+        bool operator==(const tuple8& rhs) const {
             return true && e1 == rhs.e1 && e2 == rhs.e2 && e3 == rhs.e3 && e4 == rhs.e4 && e5 == rhs.e5 && e6 == rhs.e6 && e7 == rhs.e7 && e8 == rhs.e8;
         }
 
-        bool operator!=(tuple8 rhs) {
+        bool operator!=(const tuple8& rhs) const {
             return !(rhs == *this);
         }
     };
@@ -493,11 +1350,11 @@ namespace Prelude {
         g e7;
         h e8;
         i e9;
-        bool operator==(tuple9 rhs) {
+        bool operator==(const tuple9& rhs) const {
             return true && e1 == rhs.e1 && e2 == rhs.e2 && e3 == rhs.e3 && e4 == rhs.e4 && e5 == rhs.e5 && e6 == rhs.e6 && e7 == rhs.e7 && e8 == rhs.e8 && e9 == rhs.e9;
         }
 
-        bool operator!=(tuple9 rhs) {
+        bool operator!=(const tuple9& rhs) const {
             return !(rhs == *this);
         }
     };
@@ -516,11 +1373,11 @@ namespace Prelude {
         h e8;
         i e9;
         j e10;
-        bool operator==(tuple10 rhs) {
+        bool operator==(const tuple10& rhs) const {
             return true && e1 == rhs.e1 && e2 == rhs.e2 && e3 == rhs.e3 && e4 == rhs.e4 && e5 == rhs.e5 && e6 == rhs.e6 && e7 == rhs.e7 && e8 == rhs.e8 && e9 == rhs.e9 && e10 == rhs.e10;
         }
 
-        bool operator!=(tuple10 rhs) {
+        bool operator!=(const tuple10& rhs) const {
             return !(rhs == *this);
         }
     };
@@ -530,7 +1387,7 @@ namespace Prelude {
     template<typename a>
     struct maybe {
         uint8_t tag;
-        bool operator==(maybe rhs) {
+        bool operator==(const maybe& rhs) const {
             if (this->tag != rhs.tag) { return false; }
             switch (this->tag) {
                 case 0:
@@ -541,7 +1398,7 @@ namespace Prelude {
             return false;
         }
 
-        bool operator!=(maybe rhs) { return !(rhs == *this); }
+        bool operator!=(const maybe& rhs) const { return !(rhs == *this); }
         union {
             a just;
             uint8_t nothing;
@@ -565,7 +1422,7 @@ namespace Prelude {
     template<typename a, typename b>
     struct either {
         uint8_t tag;
-        bool operator==(either rhs) {
+        bool operator==(const either& rhs) const {
             if (this->tag != rhs.tag) { return false; }
             switch (this->tag) {
                 case 0:
@@ -576,7 +1433,7 @@ namespace Prelude {
             return false;
         }
 
-        bool operator!=(either rhs) { return !(rhs == *this); }
+        bool operator!=(const either& rhs) const { return !(rhs == *this); }
         union {
             a left;
             b right;
@@ -601,11 +1458,11 @@ namespace Prelude {
     struct list {
         juniper::array<a, n> data;
         uint32_t length;
-        bool operator==(list rhs) {
+        bool operator==(const list& rhs) const {
             return true && data == rhs.data && length == rhs.length;
         }
 
-        bool operator!=(list rhs) {
+        bool operator!=(const list& rhs) const {
             return !(rhs == *this);
         }
     };
@@ -615,7 +1472,7 @@ namespace Prelude {
     template<typename a>
     struct sig {
         uint8_t tag;
-        bool operator==(sig rhs) {
+        bool operator==(const sig& rhs) const {
             if (this->tag != rhs.tag) { return false; }
             switch (this->tag) {
                 case 0:
@@ -624,7 +1481,7 @@ namespace Prelude {
             return false;
         }
 
-        bool operator!=(sig rhs) { return !(rhs == *this); }
+        bool operator!=(const sig& rhs) const { return !(rhs == *this); }
         union {
             Prelude::maybe<a> signal;
         };
@@ -641,7 +1498,7 @@ namespace Prelude {
 namespace Io {
     struct pinState {
         uint8_t tag;
-        bool operator==(pinState rhs) {
+        bool operator==(const pinState& rhs) const {
             if (this->tag != rhs.tag) { return false; }
             switch (this->tag) {
                 case 0:
@@ -652,7 +1509,7 @@ namespace Io {
             return false;
         }
 
-        bool operator!=(pinState rhs) { return !(rhs == *this); }
+        bool operator!=(const pinState& rhs) const { return !(rhs == *this); }
         union {
             uint8_t high;
             uint8_t low;
@@ -673,7 +1530,7 @@ namespace Io {
 namespace Io {
     struct mode {
         uint8_t tag;
-        bool operator==(mode rhs) {
+        bool operator==(const mode& rhs) const {
             if (this->tag != rhs.tag) { return false; }
             switch (this->tag) {
                 case 0:
@@ -686,7 +1543,7 @@ namespace Io {
             return false;
         }
 
-        bool operator!=(mode rhs) { return !(rhs == *this); }
+        bool operator!=(const mode& rhs) const { return !(rhs == *this); }
         union {
             uint8_t input;
             uint8_t output;
@@ -712,7 +1569,7 @@ namespace Io {
 namespace Io {
     struct base {
         uint8_t tag;
-        bool operator==(base rhs) {
+        bool operator==(const base& rhs) const {
             if (this->tag != rhs.tag) { return false; }
             switch (this->tag) {
                 case 0:
@@ -727,7 +1584,7 @@ namespace Io {
             return false;
         }
 
-        bool operator!=(base rhs) { return !(rhs == *this); }
+        bool operator!=(const base& rhs) const { return !(rhs == *this); }
         union {
             uint8_t binary;
             uint8_t octal;
@@ -758,11 +1615,27 @@ namespace Io {
 namespace Time {
     struct timerState {
         uint32_t lastPulse;
-        bool operator==(timerState rhs) {
-            return true && lastPulse == rhs.lastPulse;
+        uint8_t timer;
+        bool operator==(const timerState& rhs) const {
+            return true && lastPulse == rhs.lastPulse && timer == rhs.timer;
+        }
+
+        bool operator!=(const timerState& rhs) const {
+            return !(rhs == *this);
+        }
+    };
+}
+
+namespace Time {
+    struct domainState {
+        uint32_t period;
+        uint32_t nextTick;
+        bool started;
+        bool operator==(const domainState& rhs) const {
+            return true && period == rhs.period && nextTick == rhs.nextTick && started == rhs.started;
         }
 
-        bool operator!=(timerState rhs) {
+        bool operator!=(const domainState& rhs) const {
             return !(rhs == *this);
         }
     };
@@ -773,11 +1646,11 @@ namespace Button {
         Io::pinState actualState;
         Io::pinState lastState;
         uint32_t lastDebounceTime;
-        bool operator==(buttonState rhs) {
+        bool operator==(const buttonState& rhs) const {
             return true && actualState == rhs.actualState && lastState == rhs.lastState && lastDebounceTime == rhs.lastDebounceTime;
         }
 
-        bool operator!=(buttonState rhs) {
+        bool operator!=(const buttonState& rhs) const {
             return !(rhs == *this);
         }
     };
@@ -787,39 +1660,40 @@ namespace Vector {
     template<typename a, int n>
     struct vector {
         juniper::array<a, n> data;
-        bool operator==(vector rhs) {
+        bool operator==(const vector& rhs) const {
             return true && data == rhs.data;
         }
 
-        bool operator!=(vector rhs) {
+        bool operator!=(const vector& rhs) const {
             return !(rhs == *this);
         }
     };
 }
 
 namespace FastLed {
-    struct fastLedStrip {
-        juniper::shared_ptr<void> ptr;
-        bool operator==(fastLedStrip rhs) {
-            return true && ptr == rhs.ptr;
+    struct color {
+        uint8_t r;
+        uint8_t g;
+        uint8_t b;
+        bool operator==(const color& rhs) const {
+            return true && r == rhs.r && g == rhs.g && b == rhs.b;
         }
 
-        bool operator!=(fastLedStrip rhs) {
+        bool operator!=(const color& rhs) const {
             return !(rhs == *this);
         }
     };
 }
 
 namespace FastLed {
-    struct color {
-        uint8_t r;
-        uint8_t g;
-        uint8_t b;
-        bool operator==(color rhs) {
-            return true && r == rhs.r && g == rhs.g && b == rhs.b;
+    struct range {
+        uint16_t first;
+        uint16_t last;
+        bool operator==(const range& rhs) const {
+            return true && first == rhs.first && last == rhs.last;
         }
 
-        bool operator!=(color rhs) {
+        bool operator!=(const range& rhs) const {
             return !(rhs == *this);
         }
     };
@@ -828,7 +1702,7 @@ namespace FastLed {
 namespace Accelerometer {
     struct axis {
         uint8_t tag;
-        bool operator==(axis rhs) {
+        bool operator==(const axis& rhs) const {
             if (this->tag != rhs.tag) { return false; }
             switch (this->tag) {
                 case 0:
@@ -841,7 +1715,7 @@ namespace Accelerometer {
             return false;
         }
 
-        bool operator!=(axis rhs) { return !(rhs == *this); }
+        bool operator!=(const axis& rhs) const { return !(rhs == *this); }
         union {
             uint8_t xAxis;
             uint8_t yAxis;
@@ -867,7 +1741,7 @@ namespace Accelerometer {
 namespace Accelerometer {
     struct orientation {
         uint8_t tag;
-        bool operator==(orientation rhs) {
+        bool operator==(const orientation& rhs) const {
             if (this->tag != rhs.tag) { return false; }
             switch (this->tag) {
                 case 0:
@@ -886,7 +1760,7 @@ namespace Accelerometer {
             return false;
         }
 
-        bool operator!=(orientation rhs) { return !(rhs == *this); }
+        bool operator!=(const orientation& rhs) const { return !(rhs == *this); }
         union {
             uint8_t xUp;
             uint8_t xDown;
@@ -928,11 +1802,11 @@ namespace Setting {
     struct timeSetting {
         int32_t minutes;
         int32_t fifteenSeconds;
-        bool operator==(timeSetting rhs) {
+        bool operator==(const timeSetting& rhs) const {
             return true && minutes == rhs.minutes && fifteenSeconds == rhs.fifteenSeconds;
         }
 
-        bool operator!=(timeSetting rhs) {
+        bool operator!=(const timeSetting& rhs) const {
             return !(rhs == *this);
         }
     };
@@ -941,7 +1815,7 @@ namespace Setting {
 namespace Program {
     struct mode {
         uint8_t tag;
-        bool operator==(mode rhs) {
+        bool operator==(const mode& rhs) const {
             if (this->tag != rhs.tag) { return false; }
             switch (this->tag) {
                 case 0:
@@ -956,7 +1830,7 @@ namespace Program {
             return false;
         }
 
-        bool operator!=(mode rhs) { return !(rhs == *this); }
+        bool operator!=(const mode& rhs) const { return !(rhs == *this); }
         union {
             uint8_t setting;
             uint8_t timing;
@@ -987,7 +1861,7 @@ namespace Program {
 namespace Program {
     struct flip {
         uint8_t tag;
-        bool operator==(flip rhs) {
+        bool operator==(const flip& rhs) const {
             if (this->tag != rhs.tag) { return false; }
             switch (this->tag) {
                 case 0:
@@ -1000,7 +1874,7 @@ namespace Program {
             return false;
         }
 
-        bool operator!=(flip rhs) { return !(rhs == *this); }
+        bool operator!=(const flip& rhs) const { return !(rhs == *this); }
         union {
             uint8_t flipUp;
             uint8_t flipDown;
@@ -1152,62 +2026,62 @@ namespace Prelude {
 
 namespace List {
     template<typename t161, typename t162, int c1>
-    Prelude::list<t162, c1> map(juniper::function<t162(t161)> f, Prelude::list<t161, c1> lst);
+    Prelude::list<t162, c1> map(juniper::function_ref<t162(t161)> f, const Prelude::list<t161, c1>& lst);
 }
 
 namespace List {
     template<typename t171, typename t172, int c4>
-    t172 foldl(juniper::function<t172(t171,t172)> f, t172 initState, Prelude::list<t171, c4> lst);
+    t172 foldl(juniper::function_ref<t172(t171,t172)> f, t172 initState, const Prelude::list<t171, c4>& lst);
 }
 
 namespace List {
     template<typename t180, typename t181, int c6>
-    t181 foldr(juniper::function<t181(t180,t181)> f, t181 initState, Prelude::list<t180, c6> lst);
+    t181 foldr(juniper::function_ref<t181(t180,t181)> f, t181 initState, const Prelude::list<t180, c6>& lst);
 }
 
 namespace List {
     template<typename t189, int c8, int c9, int c10>
-    Prelude::list<t189, c10> append(Prelude::list<t189, c8> lstA, Prelude::list<t189, c9> lstB);
+    Prelude::list<t189, c10> append(const Prelude::list<t189, c8>& lstA, const Prelude::list<t189, c9>& lstB);
 }
 
 namespace List {
     template<typename t205, int c16>
-    t205 nth(uint32_t i, Prelude::list<t205, c16> lst);
+    t205 nth(uint32_t i, const Prelude::list<t205, c16>& lst);
 }
 
 namespace List {
     template<typename t207, int c17, int c18>
-    Prelude::list<t207, (c17)*(c18)> flattenSafe(Prelude::list<Prelude::list<t207, c17>, c18> listOfLists);
+    Prelude::list<t207, (c17)*(c18)> flattenSafe(const Prelude::list<Prelude::list<t207, c17>, c18>& listOfLists);
 }
 
 namespace List {
     template<typename t218, int c23, int c24>
-    Prelude::list<t218, c24> resize(Prelude::list<t218, c23> lst);
+    Prelude::list<t218, c24> resize(const Prelude::list<t218, c23>& lst);
 }
 
 namespace List {
     template<typename t225, int c27>
-    bool all(juniper::function<bool(t225)> pred, Prelude::list<t225, c27> lst);
+    bool all(juniper::function_ref<bool(t225)> pred, const Prelude::list<t225, c27>& lst);
 }
 
 namespace List {
     template<typename t232, int c29>
-    bool any(juniper::function<bool(t232)> pred, Prelude::list<t232, c29> lst);
+    bool any(juniper::function_ref<bool(t232)> pred, const Prelude::list<t232, c29>& lst);
 }
 
 namespace List {
     template<typename t239, int c31>
-    Prelude::list<t239, c31> pushBack(t239 elem, Prelude::list<t239, c31> lst);
+    Prelude::list<t239, c31> pushBack(t239 elem, const Prelude::list<t239, c31>& lst);
 }
 
 namespace List {
     template<typename t247, int c33>
-    Prelude::list<t247, c33> pushOffFront(t247 elem, Prelude::list<t247, c33> lst);
+    Prelude::list<t247, c33> pushOffFront(t247 elem, const Prelude::list<t247, c33>& lst);
 }
 
 namespace List {
     template<typename t258, int c37>
-    Prelude::list<t258, c37> setNth(uint32_t index, t258 elem, Prelude::list<t258, c37> lst);
+    Prelude::list<t258, c37> setNth(uint32_t index, t258 elem, const Prelude::list<t258, c37>& lst);
 }
 
 namespace List {
@@ -1217,72 +2091,92 @@ namespace List {
 
 namespace List {
     template<typename t265, int c40>
-    Prelude::list<t265, c40> remove(t265 elem, Prelude::list<t265, c40> lst);
+    Prelude::list<t265, c40> remove(t265 elem, const Prelude::list<t265, c40>& lst);
 }
 
 namespace List {
     template<typename t277, int c44>
-    Prelude::list<t277, c44> dropLast(Prelude::list<t277, c44> lst);
+    Prelude::list<t277, c44> dropLast(const Prelude::list<t277, c44>& lst);
 }
 
 namespace List {
     template<typename t282, int c45>
-    Prelude::unit foreach(juniper::function<Prelude::unit(t282)> f, Prelude::list<t282, c45> lst);
+    Prelude::unit foreach(juniper::function<Prelude::unit(t282)> f, const Prelude::list<t282, c45>& lst);
 }
 
 namespace List {
     template<typename t290, int c48>
-    t290 last(Prelude::list<t290, c48> lst);
+    t290 last(const Prelude::list<t290, c48>& lst);
 }
 
 namespace List {
     template<typename t295, int c49>
-    t295 max_(Prelude::list<t295, c49> lst);
+    t295 max_(const Prelude::list<t295, c49>& lst);
 }
 
 namespace List {
     template<typename t305, int c53>
-    t305 min_(Prelude::list<t305, c53> lst);
+    t305 min_(const Prelude::list<t305, c53>& lst);
 }
 
 namespace List {
     template<typename t312, int c57>
-    bool member(t312 elem, Prelude::list<t312, c57> lst);
+    bool member(t312 elem, const Prelude::list<t312, c57>& lst);
 }
 
 namespace List {
     template<typename t317, typename t318, int c59>
-    Prelude::list<Prelude::tuple2<t317,t318>, c59> zip(Prelude::list<t317, c59> lstA, Prelude::list<t318, c59> lstB);
+    Prelude::list<Prelude::tuple2<t317,t318>, c59> zip(const Prelude::list<t317, c59>& lstA, const Prelude::list<t318, c59>& lstB);
 }
 
 namespace List {
     template<typename t330, typename t331, int c63>
-    Prelude::tuple2<Prelude::list<t330, c63>,Prelude::list<t331, c63>> unzip(Prelude::list<Prelude::tuple2<t330,t331>, c63> lst);
+    Prelude::tuple2<Prelude::list<t330, c63>,Prelude::list<t331, c63>> unzip(const Prelude::list<Prelude::tuple2<t330,t331>, c63>& lst);
 }
 
 namespace List {
     template<typename t336, int c64>
-    t336 sum(Prelude::list<t336, c64> lst);
+    t336 sum(const Prelude::list<t336, c64>& lst);
 }
 
 namespace List {
     template<typename t345, int c65>
-    t345 average(Prelude::list<t345, c65> lst);
+    t345 average(const Prelude::list<t345, c65>& lst);
+}
+
+namespace List {
+    template<typename t1130, int c115>
+    t1130 sum(const juniper::ring_window<t1130, c115>& window);
+}
+
+namespace List {
+    template<typename t1131, int c116>
+    t1131 average(const juniper::ring_window<t1131, c116>& window);
+}
+
+namespace List {
+    template<typename t1132, int c117>
+    t1132 max_(const juniper::ring_window<t1132, c117>& window);
+}
+
+namespace List {
+    template<typename t1133, int c118>
+    t1133 min_(const juniper::ring_window<t1133, c118>& window);
 }
 
 namespace Signal {
     template<typename t347, typename t348>
-    Prelude::sig<t348> map(juniper::function<t348(t347)> f, Prelude::sig<t347> s);
+    Prelude::sig<t348> map(juniper::function_ref<t348(t347)> f, Prelude::sig<t347> s);
 }
 
 namespace Signal {
     template<typename t359>
-    Prelude::unit sink(juniper::function<Prelude::unit(t359)> f, Prelude::sig<t359> s);
+    Prelude::unit sink(juniper::function_ref<Prelude::unit(t359)> f, Prelude::sig<t359> s);
 }
 
 namespace Signal {
     template<typename t363>
-    Prelude::sig<t363> filter(juniper::function<bool(t363)> f, Prelude::sig<t363> s);
+    Prelude::sig<t363> filter(juniper::function_ref<bool(t363)> f, Prelude::sig<t363> s);
 }
 
 namespace Signal {
@@ -1292,7 +2186,7 @@ namespace Signal {
 
 namespace Signal {
     template<typename t375, int c66>
-    Prelude::sig<t375> mergeMany(Prelude::list<Prelude::sig<t375>, c66> sigs);
+    Prelude::sig<t375> mergeMany(const Prelude::list<Prelude::sig<t375>, c66>& sigs);
 }
 
 namespace Signal {
@@ -1307,7 +2201,7 @@ namespace Signal {
 
 namespace Signal {
     template<typename t411, typename t417>
-    Prelude::sig<t417> foldP(juniper::function<t417(t411,t417)> f, juniper::shared_ptr<t417> state0, Prelude::sig<t411> incoming);
+    Prelude::sig<t417> foldP(juniper::function_ref<t417(t411,t417)> f, juniper::shared_ptr<t417> state0, Prelude::sig<t411> incoming);
 }
 
 namespace Signal {
@@ -1322,7 +2216,7 @@ namespace Signal {
 
 namespace Signal {
     template<typename t448, typename t451, typename t446>
-    Prelude::sig<t446> map2(juniper::function<t446(t448,t451)> f, Prelude::sig<t448> incomingA, Prelude::sig<t451> incomingB, juniper::shared_ptr<Prelude::tuple2<t448,t451>> state);
+    Prelude::sig<t446> map2(juniper::function_ref<t446(t448,t451)> f, Prelude::sig<t448> incomingA, Prelude::sig<t451> incomingB, juniper::shared_ptr<Prelude::tuple2<t448,t451>> state);
 }
 
 namespace Signal {
@@ -1330,6 +2224,66 @@ namespace Signal {
     Prelude::sig<Prelude::list<t467, c67>> record(Prelude::sig<t467> incoming, juniper::shared_ptr<Prelude::list<t467, c67>> pastValues);
 }
 
+namespace Signal {
+    template<typename t1134, int c119>
+    Prelude::sig<juniper::ring_window<t1134, c119>> history(Prelude::sig<t1134> incoming, juniper::shared_ptr<juniper::ring<t1134, c119>> samples);
+}
+
+namespace Signal {
+    template<typename t1137, typename t1138>
+    Prelude::sig<juniper::slots_view<Prelude::tuple2<t1137,t1138>>> holdLatest(Prelude::sig<t1137> incomingA, Prelude::sig<t1138> incomingB, juniper::shared_ptr<juniper::tracked<Prelude::tuple2<t1137,t1138>>> state);
+}
+
+namespace Signal {
+    template<typename t1139>
+    const t1139& slots(const juniper::slots_view<t1139>& view);
+}
+
+namespace Signal {
+    template<typename t1140>
+    juniper::tracked<t1140> track(t1140 value);
+}
+
+namespace Signal {
+    template<typename t1141>
+    Prelude::unit update(juniper::shared_ptr<juniper::tracked<t1141>> state, t1141 value);
+}
+
+namespace Signal {
+    template<typename t1142>
+    Prelude::unit sinkChanged(juniper::function_ref<Prelude::unit(juniper::slots_view<t1142>)> f, Prelude::sig<juniper::slots_view<t1142>> incoming, juniper::shared_ptr<uint32_t> seen);
+}
+
+namespace Signal {
+    template<typename t1143, int c120>
+    Prelude::sig<juniper::batch<t1143, c120>> repeated(t1143 value, uint16_t times);
+}
+
+namespace Signal {
+    template<typename t1144, int c121>
+    Prelude::sig<t1144> latest(Prelude::sig<juniper::batch<t1144, c121>> incoming);
+}
+
+namespace Signal {
+    template<typename t1145, int c122>
+    Prelude::sig<uint16_t> count(Prelude::sig<juniper::batch<t1145, c122>> incoming);
+}
+
+namespace Signal {
+    template<typename t1146, typename t1147, int c123>
+    Prelude::sig<t1147> foldP(juniper::function_ref<t1147(t1146,t1147)> f, juniper::shared_ptr<t1147> state0, Prelude::sig<juniper::batch<t1146, c123>> incoming);
+}
+
+namespace Signal {
+    template<typename t1148, typename t1149>
+    Prelude::sig<t1149> sampleHold(juniper::function_ref<Prelude::sig<t1149>()> f, Prelude::sig<t1148> tick, juniper::shared_ptr<Prelude::maybe<t1149>> held);
+}
+
+namespace Signal {
+    template<typename t1150, typename t1151>
+    Prelude::sig<t1151> gate(Prelude::sig<t1150> tick, Prelude::sig<t1151> incoming);
+}
+
 namespace Io {
     Io::pinState toggle(Io::pinState p);
 }
@@ -1340,7 +2294,7 @@ namespace Io {
 
 namespace Io {
     template<int c68>
-    Prelude::unit printCharList(Prelude::list<uint8_t, c68> cl);
+    Prelude::unit printCharList(const Prelude::list<uint8_t, c68>& cl);
 }
 
 namespace Io {
@@ -1487,6 +2441,22 @@ namespace Time {
     Prelude::sig<uint32_t> every(uint32_t interval, juniper::shared_ptr<Time::timerState> state);
 }
 
+namespace Time {
+    Prelude::unit cancel(juniper::shared_ptr<Time::timerState> state);
+}
+
+namespace Time {
+    Time::domainState domain(uint32_t period);
+}
+
+namespace Time {
+    Prelude::sig<uint32_t> tick(juniper::shared_ptr<Time::domainState> domain);
+}
+
+namespace Time {
+    Prelude::unit demand(juniper::shared_ptr<Time::domainState> domain);
+}
+
 namespace Math {
     double degToRad(double degrees);
 }
@@ -1613,10 +2583,18 @@ namespace Button {
     juniper::shared_ptr<Button::buttonState> state();
 }
 
+namespace Button {
+    Prelude::sig<Io::pinState> debounceDelayAt(Prelude::sig<Prelude::tuple2<Io::pinState,uint32_t>> incoming, uint16_t delay, juniper::shared_ptr<Button::buttonState> buttonState);
+}
+
 namespace Button {
     Prelude::sig<Io::pinState> debounceDelay(Prelude::sig<Io::pinState> incoming, uint16_t delay, juniper::shared_ptr<Button::buttonState> buttonState);
 }
 
+namespace Button {
+    Prelude::sig<Io::pinState> debounceAt(Prelude::sig<Prelude::tuple2<Io::pinState,uint32_t>> incoming, juniper::shared_ptr<Button::buttonState> buttonState);
+}
+
 namespace Button {
     Prelude::sig<Io::pinState> debounce(Prelude::sig<Io::pinState> incoming, juniper::shared_ptr<Button::buttonState> buttonState);
 }
@@ -1628,12 +2606,12 @@ namespace Vector {
 
 namespace Vector {
     template<typename t682, int c71>
-    t682 get(uint32_t i, Vector::vector<t682, c71> v);
+    t682 get(uint32_t i, const Vector::vector<t682, c71>& v);
 }
 
 namespace Vector {
     template<typename t684, int c72>
-    Vector::vector<t684, c72> add(Vector::vector<t684, c72> v1, Vector::vector<t684, c72> v2);
+    Vector::vector<t684, c72> add(const Vector::vector<t684, c72>& v1, const Vector::vector<t684, c72>& v2);
 }
 
 namespace Vector {
@@ -1643,81 +2621,123 @@ namespace Vector {
 
 namespace Vector {
     template<typename t695, int c77>
-    Vector::vector<t695, c77> subtract(Vector::vector<t695, c77> v1, Vector::vector<t695, c77> v2);
+    Vector::vector<t695, c77> subtract(const Vector::vector<t695, c77>& v1, const Vector::vector<t695, c77>& v2);
 }
 
 namespace Vector {
     template<typename t703, int c81>
-    Vector::vector<t703, c81> scale(t703 scalar, Vector::vector<t703, c81> v);
+    Vector::vector<t703, c81> scale(t703 scalar, const Vector::vector<t703, c81>& v);
 }
 
 namespace Vector {
     template<typename t709, int c84>
-    t709 dot(Vector::vector<t709, c84> v1, Vector::vector<t709, c84> v2);
+    t709 dot(const Vector::vector<t709, c84>& v1, const Vector::vector<t709, c84>& v2);
 }
 
 namespace Vector {
     template<typename t715, int c87>
-    t715 magnitude2(Vector::vector<t715, c87> v);
+    t715 magnitude2(const Vector::vector<t715, c87>& v);
 }
 
 namespace Vector {
     template<typename t721, int c90>
-    double magnitude(Vector::vector<t721, c90> v);
+    double magnitude(const Vector::vector<t721, c90>& v);
 }
 
 namespace Vector {
     template<typename t727, int c91>
-    Vector::vector<t727, c91> multiply(Vector::vector<t727, c91> u, Vector::vector<t727, c91> v);
+    Vector::vector<t727, c91> multiply(const Vector::vector<t727, c91>& u, const Vector::vector<t727, c91>& v);
 }
 
 namespace Vector {
     template<typename t735, int c95>
-    Vector::vector<t735, c95> normalize(Vector::vector<t735, c95> v);
+    Vector::vector<t735, c95> normalize(const Vector::vector<t735, c95>& v);
 }
 
 namespace Vector {
     template<typename t743, int c98>
-    double angle(Vector::vector<t743, c98> v1, Vector::vector<t743, c98> v2);
+    double angle(const Vector::vector<t743, c98>& v1, const Vector::vector<t743, c98>& v2);
 }
 
 namespace Vector {
     template<typename t781>
-    Vector::vector<t781, 3> cross(Vector::vector<t781, 3> u, Vector::vector<t781, 3> v);
+    Vector::vector<t781, 3> cross(const Vector::vector<t781, 3>& u, const Vector::vector<t781, 3>& v);
 }
 
 namespace Vector {
     template<typename t783, int c111>
-    Vector::vector<t783, c111> project(Vector::vector<t783, c111> a, Vector::vector<t783, c111> b);
+    Vector::vector<t783, c111> project(const Vector::vector<t783, c111>& a, const Vector::vector<t783, c111>& b);
 }
 
 namespace Vector {
     template<typename t793, int c112>
-    Vector::vector<t793, c112> projectPlane(Vector::vector<t793, c112> a, Vector::vector<t793, c112> m);
+    Vector::vector<t793, c112> projectPlane(const Vector::vector<t793, c112>& a, const Vector::vector<t793, c112>& m);
 }
 
 namespace CharList {
     template<int c113>
-    Prelude::list<uint8_t, c113> toUpper(Prelude::list<uint8_t, c113> str);
+    Prelude::list<uint8_t, c113> toUpper(const Prelude::list<uint8_t, c113>& str);
 }
 
 namespace CharList {
     template<int c114>
-    Prelude::list<uint8_t, c114> toLower(Prelude::list<uint8_t, c114> str);
+    Prelude::list<uint8_t, c114> toLower(const Prelude::list<uint8_t, c114>& str);
+}
+
+namespace FastLed {
+    Prelude::unit begin();
+}
+
+namespace FastLed {
+    Prelude::unit setLedColor(uint16_t n, FastLed::color c);
+}
+
+namespace FastLed {
+    FastLed::color getLedColor(uint16_t n);
+}
+
+namespace FastLed {
+    Prelude::unit beginLayer(uint8_t layer);
+}
+
+namespace FastLed {
+    Prelude::unit setLayerColor(uint8_t layer, uint16_t n, FastLed::color c);
+}
+
+namespace FastLed {
+    Prelude::unit fill(uint8_t layer, FastLed::range r, FastLed::color c);
 }
 
 namespace FastLed {
-    FastLed::fastLedStrip make(uint16_t numLeds);
+    Prelude::unit fillGradient(uint8_t layer, FastLed::range r, FastLed::color c1, FastLed::color c2);
 }
 
 namespace FastLed {
-    template<typename t822, typename t823>
-    Prelude::unit setLedColor(uint16_t n, t822 c, t823 strip);
+    Prelude::unit copyRange(uint8_t layer, FastLed::range r, uint16_t dest);
 }
 
 namespace FastLed {
-    template<typename t829>
-    FastLed::color getLedColor(uint16_t n, t829 strip);
+    Prelude::unit scaleRange(uint8_t layer, FastLed::range r, uint8_t factor);
+}
+
+namespace FastLed {
+    Prelude::unit endLayer(uint8_t layer);
+}
+
+namespace FastLed {
+    Prelude::unit setBrightness(uint8_t brightness);
+}
+
+namespace FastLed {
+    Prelude::unit resetLayers();
+}
+
+namespace FastLed {
+    Prelude::unit composite();
+}
+
+namespace FastLed {
+    FastLed::color blend(FastLed::color c1, FastLed::color c2, uint8_t amount);
 }
 
 namespace FastLed {
@@ -1732,6 +2752,10 @@ namespace Accelerometer {
     Prelude::tuple2<int32_t,int32_t> axisToRange(Accelerometer::axis a);
 }
 
+namespace Accelerometer {
+    juniper::shared_ptr<juniper::ring<int32_t, 4>> axisToSamples(Accelerometer::axis a);
+}
+
 namespace Accelerometer {
     int32_t readRaw(Accelerometer::axis a);
 }
@@ -1763,7 +2787,7 @@ namespace SignalExt {
 }
 
 namespace SignalExt {
-    template<typename t935>
+    template<typename t944>
     Prelude::sig<t944> unmeta(Prelude::sig<Prelude::maybe<t944>> sigA);
 }
 
@@ -1782,24 +2806,31 @@ namespace Timing {
 }
 
 namespace Timing {
-    template<typename t981, typename t982>
-    FastLed::color interpolate(t981 c1, t982 c2, float t);
+    FastLed::color ledColor(int32_t i);
+}
+
+namespace Timing {
+    int32_t drop(uint32_t elapsed, uint32_t totalTime);
 }
 
 namespace Timing {
-    Prelude::unit execute(juniper::shared_ptr<int32_t> timeRemaining, float totalTime);
+    Prelude::unit execute(juniper::shared_ptr<int32_t> timeRemaining, int32_t totalTime);
 }
 
 namespace Setting {
     Prelude::unit reset(juniper::shared_ptr<int32_t> timeRemaining);
 }
 
+namespace Setting {
+    uint8_t pressAt(Io::pinState level, uint32_t time);
+}
+
 namespace Setting {
     Prelude::unit execute(juniper::shared_ptr<int32_t> timeRemaining);
 }
 
 namespace Paused {
-    Prelude::unit execute(juniper::shared_ptr<int32_t> timeRemaining, float totalTime);
+    Prelude::unit execute(juniper::shared_ptr<int32_t> timeRemaining, int32_t totalTime);
 }
 
 namespace Finale {
@@ -1811,7 +2842,23 @@ namespace Program {
 }
 
 namespace Program {
-    Prelude::unit clearDisplay();
+    Program::flip orientationToFlip(Accelerometer::orientation o);
+}
+
+namespace Program {
+    Program::mode nextMode(Prelude::maybe<Program::flip> maybeFlipEvent, Program::mode prevMode);
+}
+
+namespace Program {
+    Prelude::unit executeMode(Program::mode m);
+}
+
+namespace Program {
+    Prelude::unit showFrame(uint32_t t);
+}
+
+namespace Program {
+    Prelude::unit tick();
 }
 
 namespace Program {
@@ -2089,7 +3136,7 @@ namespace Prelude {
 
 namespace List {
     template<typename t161, typename t162, int c1>
-    Prelude::list<t162, c1> map(juniper::function<t162(t161)> f, Prelude::list<t161, c1> lst) {
+    Prelude::list<t162, c1> map(juniper::function_ref<t162(t161)> f, const Prelude::list<t161, c1>& lst) {
         return (([&]() -> Prelude::list<t162, c1> {
             auto n = c1;
             return (([&]() -> Prelude::list<t162, c1> {
@@ -2097,7 +3144,7 @@ namespace List {
                 if (!(true)) {
                     juniper::quit<Prelude::unit>();
                 }
-                auto ret = guid7;
+                auto ret = juniper::move(guid7);
                 
                 (([&]() -> Prelude::unit {
                     uint32_t guid8 = 0;
@@ -2109,7 +3156,7 @@ namespace List {
                 })());
                 return (([&]() -> Prelude::list<t162, c1>{
                     Prelude::list<t162, c1> guid10;
-                    guid10.data = ret;
+                    guid10.data = juniper::move(ret);
                     guid10.length = (lst).length;
                     return guid10;
                 })());
@@ -2120,7 +3167,7 @@ namespace List {
 
 namespace List {
     template<typename t171, typename t172, int c4>
-    t172 foldl(juniper::function<t172(t171,t172)> f, t172 initState, Prelude::list<t171, c4> lst) {
+    t172 foldl(juniper::function_ref<t172(t171,t172)> f, t172 initState, const Prelude::list<t171, c4>& lst) {
         return (([&]() -> t172 {
             auto n = c4;
             return (([&]() -> t172 {
@@ -2146,7 +3193,7 @@ namespace List {
 
 namespace List {
     template<typename t180, typename t181, int c6>
-    t181 foldr(juniper::function<t181(t180,t181)> f, t181 initState, Prelude::list<t180, c6> lst) {
+    t181 foldr(juniper::function_ref<t181(t180,t181)> f, t181 initState, const Prelude::list<t180, c6>& lst) {
         return (([&]() -> t181 {
             auto n = c6;
             return (([&]() -> t181 {
@@ -2172,7 +3219,7 @@ namespace List {
 
 namespace List {
     template<typename t189, int c8, int c9, int c10>
-    Prelude::list<t189, c10> append(Prelude::list<t189, c8> lstA, Prelude::list<t189, c9> lstB) {
+    Prelude::list<t189, c10> append(const Prelude::list<t189, c8>& lstA, const Prelude::list<t189, c9>& lstB) {
         return (([&]() -> Prelude::list<t189, c10> {
             auto aCap = c8;
             auto bCap = c9;
@@ -2227,16 +3274,16 @@ namespace List {
 
 namespace List {
     template<typename t205, int c16>
-    t205 nth(uint32_t i, Prelude::list<t205, c16> lst) {
+    t205 nth(uint32_t i, const Prelude::list<t205, c16>& lst) {
         return (([&]() -> t205 {
             auto n = c16;
             return ((i < (lst).length) ? 
                 (([&]() -> t205 {
-                    auto guid24 = lst;
+                    const auto& guid24 = lst;
                     if (!(true)) {
                         juniper::quit<Prelude::unit>();
                     }
-                    auto data = (guid24).data;
+                    const auto& data = (guid24).data;
                     
                     return (data)[i];
                 })())
@@ -2248,7 +3295,7 @@ namespace List {
 
 namespace List {
     template<typename t207, int c17, int c18>
-    Prelude::list<t207, (c17)*(c18)> flattenSafe(Prelude::list<Prelude::list<t207, c17>, c18> listOfLists) {
+    Prelude::list<t207, (c17)*(c18)> flattenSafe(const Prelude::list<Prelude::list<t207, c17>, c18>& listOfLists) {
         return (([&]() -> Prelude::list<t207, (c17)*(c18)> {
             auto m = c17;
             auto n = c18;
@@ -2296,7 +3343,7 @@ namespace List {
 
 namespace List {
     template<typename t218, int c23, int c24>
-    Prelude::list<t218, c24> resize(Prelude::list<t218, c23> lst) {
+    Prelude::list<t218, c24> resize(const Prelude::list<t218, c23>& lst) {
         return (([&]() -> Prelude::list<t218, c24> {
             auto n = c23;
             auto m = c24;
@@ -2328,7 +3375,7 @@ namespace List {
 
 namespace List {
     template<typename t225, int c27>
-    bool all(juniper::function<bool(t225)> pred, Prelude::list<t225, c27> lst) {
+    bool all(juniper::function_ref<bool(t225)> pred, const Prelude::list<t225, c27>& lst) {
         return (([&]() -> bool {
             auto n = c27;
             return (([&]() -> bool {
@@ -2360,7 +3407,7 @@ namespace List {
 
 namespace List {
     template<typename t232, int c29>
-    bool any(juniper::function<bool(t232)> pred, Prelude::list<t232, c29> lst) {
+    bool any(juniper::function_ref<bool(t232)> pred, const Prelude::list<t232, c29>& lst) {
         return (([&]() -> bool {
             auto n = c29;
             return (([&]() -> bool {
@@ -2392,7 +3439,7 @@ namespace List {
 
 namespace List {
     template<typename t239, int c31>
-    Prelude::list<t239, c31> pushBack(t239 elem, Prelude::list<t239, c31> lst) {
+    Prelude::list<t239, c31> pushBack(t239 elem, const Prelude::list<t239, c31>& lst) {
         return (([&]() -> Prelude::list<t239, c31> {
             auto n = c31;
             return (((lst).length >= n) ? 
@@ -2415,7 +3462,7 @@ namespace List {
 
 namespace List {
     template<typename t247, int c33>
-    Prelude::list<t247, c33> pushOffFront(t247 elem, Prelude::list<t247, c33> lst) {
+    Prelude::list<t247, c33> pushOffFront(t247 elem, const Prelude::list<t247, c33>& lst) {
         return (([&]() -> Prelude::list<t247, c33> {
             auto n = c33;
             return (([&]() -> Prelude::list<t247, c33> {
@@ -2448,7 +3495,7 @@ namespace List {
 
 namespace List {
     template<typename t258, int c37>
-    Prelude::list<t258, c37> setNth(uint32_t index, t258 elem, Prelude::list<t258, c37> lst) {
+    Prelude::list<t258, c37> setNth(uint32_t index, t258 elem, const Prelude::list<t258, c37>& lst) {
         return (([&]() -> Prelude::list<t258, c37> {
             auto n = c37;
             return (((lst).length <= index) ? 
@@ -2485,7 +3532,7 @@ namespace List {
 
 namespace List {
     template<typename t265, int c40>
-    Prelude::list<t265, c40> remove(t265 elem, Prelude::list<t265, c40> lst) {
+    Prelude::list<t265, c40> remove(t265 elem, const Prelude::list<t265, c40>& lst) {
         return (([&]() -> Prelude::list<t265, c40> {
             auto n = c40;
             return (([&]() -> Prelude::list<t265, c40> {
@@ -2544,7 +3591,7 @@ namespace List {
 
 namespace List {
     template<typename t277, int c44>
-    Prelude::list<t277, c44> dropLast(Prelude::list<t277, c44> lst) {
+    Prelude::list<t277, c44> dropLast(const Prelude::list<t277, c44>& lst) {
         return (([&]() -> Prelude::list<t277, c44> {
             auto n = c44;
             return (((lst).length == 0) ? 
@@ -2562,7 +3609,7 @@ namespace List {
 
 namespace List {
     template<typename t282, int c45>
-    Prelude::unit foreach(juniper::function<Prelude::unit(t282)> f, Prelude::list<t282, c45> lst) {
+    Prelude::unit foreach(juniper::function<Prelude::unit(t282)> f, const Prelude::list<t282, c45>& lst) {
         return (([&]() -> Prelude::unit {
             auto n = c45;
             return (([&]() -> Prelude::unit {
@@ -2579,16 +3626,16 @@ namespace List {
 
 namespace List {
     template<typename t290, int c48>
-    t290 last(Prelude::list<t290, c48> lst) {
+    t290 last(const Prelude::list<t290, c48>& lst) {
         return (([&]() -> t290 {
             auto n = c48;
             return (([&]() -> t290 {
-                auto guid58 = lst;
+                const auto& guid58 = lst;
                 if (!(true)) {
                     juniper::quit<Prelude::unit>();
                 }
                 auto length = (guid58).length;
-                auto data = (guid58).data;
+                const auto& data = (guid58).data;
                 
                 return (data)[(length - 1)];
             })());
@@ -2598,7 +3645,7 @@ namespace List {
 
 namespace List {
     template<typename t295, int c49>
-    t295 max_(Prelude::list<t295, c49> lst) {
+    t295 max_(const Prelude::list<t295, c49>& lst) {
         return (([&]() -> t295 {
             auto n = c49;
             return ((((lst).length == 0) || (n == 0)) ? 
@@ -2633,7 +3680,7 @@ namespace List {
 
 namespace List {
     template<typename t305, int c53>
-    t305 min_(Prelude::list<t305, c53> lst) {
+    t305 min_(const Prelude::list<t305, c53>& lst) {
         return (([&]() -> t305 {
             auto n = c53;
             return ((((lst).length == 0) || (n == 0)) ? 
@@ -2668,7 +3715,7 @@ namespace List {
 
 namespace List {
     template<typename t312, int c57>
-    bool member(t312 elem, Prelude::list<t312, c57> lst) {
+    bool member(t312 elem, const Prelude::list<t312, c57>& lst) {
         return (([&]() -> bool {
             auto n = c57;
             return (([&]() -> bool {
@@ -2700,7 +3747,7 @@ namespace List {
 
 namespace List {
     template<typename t317, typename t318, int c59>
-    Prelude::list<Prelude::tuple2<t317,t318>, c59> zip(Prelude::list<t317, c59> lstA, Prelude::list<t318, c59> lstB) {
+    Prelude::list<Prelude::tuple2<t317,t318>, c59> zip(const Prelude::list<t317, c59>& lstA, const Prelude::list<t318, c59>& lstB) {
         return (([&]() -> Prelude::list<Prelude::tuple2<t317,t318>, c59> {
             auto n = c59;
             return (((lstA).length == (lstB).length) ? 
@@ -2737,7 +3784,7 @@ namespace List {
 
 namespace List {
     template<typename t330, typename t331, int c63>
-    Prelude::tuple2<Prelude::list<t330, c63>,Prelude::list<t331, c63>> unzip(Prelude::list<Prelude::tuple2<t330,t331>, c63> lst) {
+    Prelude::tuple2<Prelude::list<t330, c63>,Prelude::list<t331, c63>> unzip(const Prelude::list<Prelude::tuple2<t330,t331>, c63>& lst) {
         return (([&]() -> Prelude::tuple2<Prelude::list<t330, c63>,Prelude::list<t331, c63>> {
             auto n = c63;
             return (([&]() -> Prelude::tuple2<Prelude::list<t330, c63>,Prelude::list<t331, c63>> {
@@ -2783,7 +3830,7 @@ namespace List {
 
 namespace List {
     template<typename t336, int c64>
-    t336 sum(Prelude::list<t336, c64> lst) {
+    t336 sum(const Prelude::list<t336, c64>& lst) {
         return (([&]() -> t336 {
             auto n = c64;
             return List::foldl<t336, t336, c64>(add<t336>, 0, lst);
@@ -2793,7 +3840,7 @@ namespace List {
 
 namespace List {
     template<typename t345, int c65>
-    t345 average(Prelude::list<t345, c65> lst) {
+    t345 average(const Prelude::list<t345, c65>& lst) {
         return (([&]() -> t345 {
             auto n = c65;
             return (sum<t345, c65>(lst) / (lst).length);
@@ -2801,95 +3848,104 @@ namespace List {
     }
 }
 
+// Windowed versions of the folds above, for a ring filled by Signal::history.
+// They read the samples in place, so a long window costs no copying.
+namespace List {
+    template<typename t1130, int c115>
+    t1130 sum(const juniper::ring_window<t1130, c115>& window) {
+        t1130 total = 0;
+        for (const t1130& value : window) {
+            total = total + value;
+        }
+        return total;
+    }
+}
+
+namespace List {
+    template<typename t1131, int c116>
+    t1131 average(const juniper::ring_window<t1131, c116>& window) {
+        return (sum<t1131, c116>(window) / ((t1131) window.length()));
+    }
+}
+
+namespace List {
+    template<typename t1132, int c117>
+    t1132 max_(const juniper::ring_window<t1132, c117>& window) {
+        if (window.length() == 0) {
+            return juniper::quit<t1132>();
+        }
+        t1132 maxVal = window[0];
+        for (const t1132& value : window) {
+            if (value > maxVal) {
+                maxVal = value;
+            }
+        }
+        return maxVal;
+    }
+}
+
+namespace List {
+    template<typename t1133, int c118>
+    t1133 min_(const juniper::ring_window<t1133, c118>& window) {
+        if (window.length() == 0) {
+            return juniper::quit<t1133>();
+        }
+        t1133 minVal = window[0];
+        for (const t1133& value : window) {
+            if (value < minVal) {
+                minVal = value;
+            }
+        }
+        return minVal;
+    }
+}
+
+// The combinators below run on every tick, so each one tests its inputs
+// for an event once and builds no intermediate closures. A chain of them
+// inlines into straight-line code with one branch per stage.
 namespace Signal {
     template<typename t347, typename t348>
-    Prelude::sig<t348> map(juniper::function<t348(t347)> f, Prelude::sig<t347> s) {
-        return (([&]() -> Prelude::sig<t348> {
-            auto guid78 = s;
-            return ((((guid78).tag == 0) && ((((guid78).signal).tag == 0) && true)) ? 
-                (([&]() -> Prelude::sig<t348> {
-                    auto val = ((guid78).signal).just;
-                    return signal<t348>(just<t348>(f(val)));
-                })())
-            :
-                (true ? 
-                    (([&]() -> Prelude::sig<t348> {
-                        return signal<t348>(nothing<t348>());
-                    })())
-                :
-                    juniper::quit<Prelude::sig<t348>>()));
-        })());
+    Prelude::sig<t348> map(juniper::function_ref<t348(t347)> f, Prelude::sig<t347> s) {
+        return ((((s).signal).tag == 0) ? 
+            signal<t348>(just<t348>(f(((s).signal).just)))
+        :
+            signal<t348>(nothing<t348>()));
     }
 }
 
 namespace Signal {
     template<typename t359>
-    Prelude::unit sink(juniper::function<Prelude::unit(t359)> f, Prelude::sig<t359> s) {
-        return (([&]() -> Prelude::unit {
-            auto guid79 = s;
-            return ((((guid79).tag == 0) && ((((guid79).signal).tag == 0) && true)) ? 
-                (([&]() -> Prelude::unit {
-                    auto val = ((guid79).signal).just;
-                    return f(val);
-                })())
-            :
-                (true ? 
-                    (([&]() -> Prelude::unit {
-                        return Prelude::unit();
-                    })())
-                :
-                    juniper::quit<Prelude::unit>()));
-        })());
+    Prelude::unit sink(juniper::function_ref<Prelude::unit(t359)> f, Prelude::sig<t359> s) {
+        return ((((s).signal).tag == 0) ? 
+            f(((s).signal).just)
+        :
+            Prelude::unit());
     }
 }
 
 namespace Signal {
     template<typename t363>
-    Prelude::sig<t363> filter(juniper::function<bool(t363)> f, Prelude::sig<t363> s) {
-        return (([&]() -> Prelude::sig<t363> {
-            auto guid80 = s;
-            return ((((guid80).tag == 0) && ((((guid80).signal).tag == 0) && true)) ? 
-                (([&]() -> Prelude::sig<t363> {
-                    auto val = ((guid80).signal).just;
-                    return (f(val) ? 
-                        signal<t363>(nothing<t363>())
-                    :
-                        s);
-                })())
-            :
-                (true ? 
-                    (([&]() -> Prelude::sig<t363> {
-                        return signal<t363>(nothing<t363>());
-                    })())
-                :
-                    juniper::quit<Prelude::sig<t363>>()));
-        })());
+    Prelude::sig<t363> filter(juniper::function_ref<bool(t363)> f, Prelude::sig<t363> s) {
+        return (((((s).signal).tag == 0) && !(f(((s).signal).just))) ? 
+            s
+        :
+            signal<t363>(nothing<t363>()));
     }
 }
 
 namespace Signal {
     template<typename t373>
     Prelude::sig<t373> merge(Prelude::sig<t373> sigA, Prelude::sig<t373> sigB) {
-        return (([&]() -> Prelude::sig<t373> {
-            auto guid81 = sigA;
-            return ((((guid81).tag == 0) && ((((guid81).signal).tag == 0) && true)) ? 
-                (([&]() -> Prelude::sig<t373> {
-                    return sigA;
-                })())
-            :
-                (true ? 
-                    (([&]() -> Prelude::sig<t373> {
-                        return sigB;
-                    })())
-                :
-                    juniper::quit<Prelude::sig<t373>>()));
-        })());
+        return ((((sigA).signal).tag == 0) ? 
+            sigA
+        :
+            sigB);
     }
 }
 
 namespace Signal {
     template<typename t375, int c66>
-    Prelude::sig<t375> mergeMany(Prelude::list<Prelude::sig<t375>, c66> sigs) {
+    Prelude::sig<t375> mergeMany(const Prelude::list<Prelude::sig<t375>, c66>& sigs) {
         return (([&]() -> Prelude::sig<t375> {
             auto n = c66;
             return (([&]() -> Prelude::sig<t375> {
@@ -2965,164 +4021,62 @@ namespace Signal {
 namespace Signal {
     template<typename t406>
     Prelude::sig<Prelude::unit> toUnit(Prelude::sig<t406> s) {
-        return map<t406, Prelude::unit>(juniper::function<Prelude::unit(t406)>([=](t406 x) mutable -> Prelude::unit { 
-            return Prelude::unit();
-         }), s);
+        return ((((s).signal).tag == 0) ? 
+            signal<Prelude::unit>(just<Prelude::unit>(Prelude::unit()))
+        :
+            signal<Prelude::unit>(nothing<Prelude::unit>()));
     }
 }
 
 namespace Signal {
     template<typename t411, typename t417>
-    Prelude::sig<t417> foldP(juniper::function<t417(t411,t417)> f, juniper::shared_ptr<t417> state0, Prelude::sig<t411> incoming) {
-        return (([&]() -> Prelude::sig<t417> {
-            auto guid88 = incoming;
-            return ((((guid88).tag == 0) && ((((guid88).signal).tag == 0) && true)) ? 
-                (([&]() -> Prelude::sig<t417> {
-                    auto val = ((guid88).signal).just;
-                    return (([&]() -> Prelude::sig<t417> {
-                        auto guid89 = f(val, (*((state0).get())));
-                        if (!(true)) {
-                            juniper::quit<Prelude::unit>();
-                        }
-                        auto state1 = guid89;
-                        
-                        (*((t417*) (state0.get())) = state1);
-                        return signal<t417>(just<t417>(state1));
-                    })());
-                })())
-            :
-                (true ? 
-                    (([&]() -> Prelude::sig<t417> {
-                        return signal<t417>(nothing<t417>());
-                    })())
-                :
-                    juniper::quit<Prelude::sig<t417>>()));
-        })());
+    Prelude::sig<t417> foldP(juniper::function_ref<t417(t411,t417)> f, juniper::shared_ptr<t417> state0, Prelude::sig<t411> incoming) {
+        if (((incoming).signal).tag != 0) {
+            return signal<t417>(nothing<t417>());
+        }
+        t417& state = (*((state0).get()));
+        state = f(((incoming).signal).just, state);
+        return signal<t417>(just<t417>(state));
     }
 }
 
 namespace Signal {
     template<typename t427>
     Prelude::sig<t427> dropRepeats(Prelude::sig<t427> incoming, juniper::shared_ptr<Prelude::maybe<t427>> maybePrevValue) {
-        return filter<t427>(juniper::function<bool(t427)>([=](t427 value) mutable -> bool { 
-            return (([&]() -> bool {
-                auto guid90 = (([&]() -> bool {
-                    auto guid91 = (*((maybePrevValue).get()));
-                    return ((((guid91).tag == 1) && true) ? 
-                        (([&]() -> bool {
-                            return false;
-                        })())
-                    :
-                        ((((guid91).tag == 0) && true) ? 
-                            (([&]() -> bool {
-                                auto prevValue = (guid91).just;
-                                return (value == prevValue);
-                            })())
-                        :
-                            juniper::quit<bool>()));
-                })());
-                if (!(true)) {
-                    juniper::quit<Prelude::unit>();
-                }
-                auto filtered = guid90;
-                
-                (!(filtered) ? 
-                    (([&]() -> Prelude::unit {
-                        (*((Prelude::maybe<t427>*) (maybePrevValue.get())) = just<t427>(value));
-                        return Prelude::unit();
-                    })())
-                :
-                    Prelude::unit());
-                return filtered;
-            })());
-         }), incoming);
+        Prelude::maybe<t427>& prev = (*((maybePrevValue).get()));
+        if ((((incoming).signal).tag != 0) || ((prev.tag == 0) && (prev.just == ((incoming).signal).just))) {
+            return signal<t427>(nothing<t427>());
+        }
+        prev = ((incoming).signal);
+        return incoming;
     }
 }
 
 namespace Signal {
     template<typename t437>
     Prelude::sig<t437> latch(Prelude::sig<t437> incoming, juniper::shared_ptr<t437> prevValue) {
-        return (([&]() -> Prelude::sig<t437> {
-            auto guid92 = incoming;
-            return ((((guid92).tag == 0) && ((((guid92).signal).tag == 0) && true)) ? 
-                (([&]() -> Prelude::sig<t437> {
-                    auto val = ((guid92).signal).just;
-                    return (([&]() -> Prelude::sig<t437> {
-                        (*((t437*) (prevValue.get())) = val);
-                        return incoming;
-                    })());
-                })())
-            :
-                (true ? 
-                    (([&]() -> Prelude::sig<t437> {
-                        return signal<t437>(just<t437>((*((prevValue).get()))));
-                    })())
-                :
-                    juniper::quit<Prelude::sig<t437>>()));
-        })());
+        t437& latched = (*((prevValue).get()));
+        if (((incoming).signal).tag == 0) {
+            latched = ((incoming).signal).just;
+        }
+        return signal<t437>(just<t437>(latched));
     }
 }
 
 namespace Signal {
     template<typename t448, typename t451, typename t446>
-    Prelude::sig<t446> map2(juniper::function<t446(t448,t451)> f, Prelude::sig<t448> incomingA, Prelude::sig<t451> incomingB, juniper::shared_ptr<Prelude::tuple2<t448,t451>> state) {
-        return (([&]() -> Prelude::sig<t446> {
-            auto guid93 = (([&]() -> t448 {
-                auto guid94 = incomingA;
-                return ((((guid94).tag == 0) && ((((guid94).signal).tag == 0) && true)) ? 
-                    (([&]() -> t448 {
-                        auto val1 = ((guid94).signal).just;
-                        return val1;
-                    })())
-                :
-                    (true ? 
-                        (([&]() -> t448 {
-                            return fst<t448, t451>((*((state).get())));
-                        })())
-                    :
-                        juniper::quit<t448>()));
-            })());
-            if (!(true)) {
-                juniper::quit<Prelude::unit>();
-            }
-            auto valA = guid93;
-            
-            auto guid95 = (([&]() -> t451 {
-                auto guid96 = incomingB;
-                return ((((guid96).tag == 0) && ((((guid96).signal).tag == 0) && true)) ? 
-                    (([&]() -> t451 {
-                        auto val2 = ((guid96).signal).just;
-                        return val2;
-                    })())
-                :
-                    (true ? 
-                        (([&]() -> t451 {
-                            return snd<t448, t451>((*((state).get())));
-                        })())
-                    :
-                        juniper::quit<t451>()));
-            })());
-            if (!(true)) {
-                juniper::quit<Prelude::unit>();
-            }
-            auto valB = guid95;
-            
-            (*((Prelude::tuple2<t448,t451>*) (state.get())) = (Prelude::tuple2<t448,t451>{valA, valB}));
-            return (([&]() -> Prelude::sig<t446> {
-                auto guid97 = (Prelude::tuple2<Prelude::sig<t448>,Prelude::sig<t451>>{incomingA, incomingB});
-                return (((((guid97).e2).tag == 0) && (((((guid97).e2).signal).tag == 1) && ((((guid97).e1).tag == 0) && (((((guid97).e1).signal).tag == 1) && true)))) ? 
-                    (([&]() -> Prelude::sig<t446> {
-                        return signal<t446>(nothing<t446>());
-                    })())
-                :
-                    (true ? 
-                        (([&]() -> Prelude::sig<t446> {
-                            return signal<t446>(just<t446>(f(valA, valB)));
-                        })())
-                    :
-                        juniper::quit<Prelude::sig<t446>>()));
-            })());
-        })());
+    Prelude::sig<t446> map2(juniper::function_ref<t446(t448,t451)> f, Prelude::sig<t448> incomingA, Prelude::sig<t451> incomingB, juniper::shared_ptr<Prelude::tuple2<t448,t451>> state) {
+        Prelude::tuple2<t448,t451>& latest = (*((state).get()));
+        if (((incomingA).signal).tag == 0) {
+            latest.e1 = ((incomingA).signal).just;
+        }
+        if (((incomingB).signal).tag == 0) {
+            latest.e2 = ((incomingB).signal).just;
+        }
+        if ((((incomingA).signal).tag != 0) && (((incomingB).signal).tag != 0)) {
+            return signal<t446>(nothing<t446>());
+        }
+        return signal<t446>(just<t446>(f(latest.e1, latest.e2)));
     }
 }
 
@@ -3131,11 +4085,175 @@ namespace Signal {
     Prelude::sig<Prelude::list<t467, c67>> record(Prelude::sig<t467> incoming, juniper::shared_ptr<Prelude::list<t467, c67>> pastValues) {
         return (([&]() -> Prelude::sig<Prelude::list<t467, c67>> {
             auto n = c67;
-            return foldP<t467, Prelude::list<t467, c67>>(List::pushOffFront<t467, c67>, pastValues, incoming);
+            return foldP<t467, Prelude::list<t467, c67>>(List::pushOffFront<t467, c67>, juniper::move(pastValues), juniper::move(incoming));
         })());
     }
 }
 
+// Like record, but keeps the samples in a ring so that each event costs O(1)
+// instead of shifting and copying the whole list. The signal carries a view
+// of every retained sample; use window() on the ring for a shorter one.
+namespace Signal {
+    template<typename t1134, int c119>
+    Prelude::sig<juniper::ring_window<t1134, c119>> history(Prelude::sig<t1134> incoming, juniper::shared_ptr<juniper::ring<t1134, c119>> samples) {
+        if (((incoming).signal).tag != 0) {
+            return signal<juniper::ring_window<t1134, c119>>(nothing<juniper::ring_window<t1134, c119>>());
+        }
+        juniper::ring<t1134, c119>& ring = (*((samples).get()));
+        ring.push(((incoming).signal).just);
+        return signal<juniper::ring_window<t1134, c119>>(just<juniper::ring_window<t1134, c119>>(ring.all()));
+    }
+}
+
+// Like zip, but the latest value of each input is written into its slot of
+// state in place and the signal carries a view of the slots, so no tuple is
+// built or copied per event. The view is emitted on every evaluation,
+// starting from the initial contents of state, and the generation of state
+// moves on only when a slot changes value.
+namespace Signal {
+    template<typename t1137, typename t1138>
+    Prelude::sig<juniper::slots_view<Prelude::tuple2<t1137,t1138>>> holdLatest(Prelude::sig<t1137> incomingA, Prelude::sig<t1138> incomingB, juniper::shared_ptr<juniper::tracked<Prelude::tuple2<t1137,t1138>>> state) {
+        juniper::tracked<Prelude::tuple2<t1137,t1138>>& latest = (*((state).get()));
+        if ((((incomingA).signal).tag == 0) && (latest.value.e1 != ((incomingA).signal).just)) {
+            latest.value.e1 = ((incomingA).signal).just;
+            latest.generation++;
+        }
+        if ((((incomingB).signal).tag == 0) && (latest.value.e2 != ((incomingB).signal).just)) {
+            latest.value.e2 = ((incomingB).signal).just;
+            latest.generation++;
+        }
+        return signal<juniper::slots_view<Prelude::tuple2<t1137,t1138>>>(just<juniper::slots_view<Prelude::tuple2<t1137,t1138>>>(juniper::slots_view<Prelude::tuple2<t1137,t1138>>(&latest)));
+    }
+}
+
+namespace Signal {
+    template<typename t1139>
+    const t1139& slots(const juniper::slots_view<t1139>& view) {
+        return *view;
+    }
+}
+
+// Initial contents for the state of holdLatest
+namespace Signal {
+    template<typename t1140>
+    juniper::tracked<t1140> track(t1140 value) {
+        return (juniper::tracked<t1140>{value, 1});
+    }
+}
+
+// Replaces the contents of tracked state, moving its generation on if the
+// value differs
+namespace Signal {
+    template<typename t1141>
+    Prelude::unit update(juniper::shared_ptr<juniper::tracked<t1141>> state, t1141 value) {
+        juniper::tracked<t1141>& current = (*((state).get()));
+        if (current.value != value) {
+            current.value = value;
+            current.generation++;
+        }
+        return Prelude::unit();
+    }
+}
+
+// Like sink, but only calls f when the view has a generation other than the
+// one stored in seen. Set seen to 0 to force the next call, for example when
+// something else has overwritten what f produced.
+namespace Signal {
+    template<typename t1142>
+    Prelude::unit sinkChanged(juniper::function_ref<Prelude::unit(juniper::slots_view<t1142>)> f, Prelude::sig<juniper::slots_view<t1142>> incoming, juniper::shared_ptr<uint32_t> seen) {
+        if (((incoming).signal).tag == 0) {
+            const juniper::slots_view<t1142>& view = ((incoming).signal).just;
+            uint32_t& last = (*((seen).get()));
+            if (view.generation() != last) {
+                last = view.generation();
+                f(view);
+            }
+        }
+        return Prelude::unit();
+    }
+}
+
+// Batched signals carry every event of a tick instead of one. How a
+// combinator coalesces a batch is chosen by picking the combinator: latest
+// keeps the newest event, count the number of events, and the batched foldP
+// below folds over all of them.
+
+// A batch holding value times, for sources that count their events, or
+// nothing when times is 0
+namespace Signal {
+    template<typename t1143, int c120>
+    Prelude::sig<juniper::batch<t1143, c120>> repeated(t1143 value, uint16_t times) {
+        if (times == 0) {
+            return signal<juniper::batch<t1143, c120>>(nothing<juniper::batch<t1143, c120>>());
+        }
+        juniper::batch<t1143, c120> events = juniper::batch<t1143, c120>::empty();
+        for (uint16_t i = 0; i < times; i++) {
+            events.push(value);
+        }
+        return signal<juniper::batch<t1143, c120>>(just<juniper::batch<t1143, c120>>(events));
+    }
+}
+
+namespace Signal {
+    template<typename t1144, int c121>
+    Prelude::sig<t1144> latest(Prelude::sig<juniper::batch<t1144, c121>> incoming) {
+        if (((incoming).signal).tag != 0) {
+            return signal<t1144>(nothing<t1144>());
+        }
+        return signal<t1144>(just<t1144>(((incoming).signal).just.latest()));
+    }
+}
+
+namespace Signal {
+    template<typename t1145, int c122>
+    Prelude::sig<uint16_t> count(Prelude::sig<juniper::batch<t1145, c122>> incoming) {
+        if (((incoming).signal).tag != 0) {
+            return signal<uint16_t>(nothing<uint16_t>());
+        }
+        return signal<uint16_t>(just<uint16_t>(((incoming).signal).just.total()));
+    }
+}
+
+// Folds every event of the batch into the state in one call, oldest first,
+// and emits the final state
+namespace Signal {
+    template<typename t1146, typename t1147, int c123>
+    Prelude::sig<t1147> foldP(juniper::function_ref<t1147(t1146,t1147)> f, juniper::shared_ptr<t1147> state0, Prelude::sig<juniper::batch<t1146, c123>> incoming) {
+        if (((incoming).signal).tag != 0) {
+            return signal<t1147>(nothing<t1147>());
+        }
+        t1147& state = (*((state0).get()));
+        for (const t1146& event : ((incoming).signal).just) {
+            state = f(event, state);
+        }
+        return signal<t1147>(just<t1147>(state));
+    }
+}
+
+// Crosses a signal into a slower domain: f is only evaluated when tick has
+// a value, and its latest value is held and emitted in between
+namespace Signal {
+    template<typename t1148, typename t1149>
+    Prelude::sig<t1149> sampleHold(juniper::function_ref<Prelude::sig<t1149>()> f, Prelude::sig<t1148> tick, juniper::shared_ptr<Prelude::maybe<t1149>> held) {
+        Prelude::maybe<t1149>& sample = (*((held).get()));
+        if (((tick).signal).tag == 0) {
+            sample = (f()).signal;
+        }
+        return signal<t1149>(sample);
+    }
+}
+
+// Crosses a signal into a domain by passing it on only when tick has a value
+namespace Signal {
+    template<typename t1150, typename t1151>
+    Prelude::sig<t1151> gate(Prelude::sig<t1150> tick, Prelude::sig<t1151> incoming) {
+        if (((tick).signal).tag != 0) {
+            return signal<t1151>(nothing<t1151>());
+        }
+        return incoming;
+    }
+}
+
 namespace Io {
     Io::pinState toggle(Io::pinState p) {
         return (([&]() -> Io::pinState {
@@ -3166,7 +4284,7 @@ namespace Io {
 
 namespace Io {
     template<int c68>
-    Prelude::unit printCharList(Prelude::list<uint8_t, c68> cl) {
+    Prelude::unit printCharList(const Prelude::list<uint8_t, c68>& cl) {
         return (([&]() -> Prelude::unit {
             auto n = c68;
             return (([&]() -> Prelude::unit {
@@ -3330,9 +4448,9 @@ namespace Io {
 
 namespace Io {
     Prelude::unit digOut(uint16_t pin, Prelude::sig<Io::pinState> sig) {
-        return Signal::sink<Io::pinState>(juniper::function<Prelude::unit(Io::pinState)>([=](Io::pinState value) mutable -> Prelude::unit { 
+        return Signal::sink<Io::pinState>([=](Io::pinState value) mutable -> Prelude::unit { 
             return digWrite(pin, value);
-         }), sig);
+         }, juniper::move(sig));
     }
 }
 
@@ -3371,9 +4489,9 @@ namespace Io {
 
 namespace Io {
     Prelude::unit anaOut(uint16_t pin, Prelude::sig<uint16_t> sig) {
-        return Signal::sink<uint16_t>(juniper::function<Prelude::unit(uint16_t)>([=](uint16_t value) mutable -> Prelude::unit { 
+        return Signal::sink<uint16_t>([=](uint16_t value) mutable -> Prelude::unit { 
             return anaWrite(pin, value);
-         }), sig);
+         }, juniper::move(sig));
     }
 }
 
@@ -3444,7 +4562,7 @@ namespace Io {
 
 namespace Io {
     Prelude::sig<Prelude::unit> risingEdge(Prelude::sig<Io::pinState> sig, juniper::shared_ptr<Io::pinState> prevState) {
-        return Signal::toUnit<Io::pinState>(Signal::filter<Io::pinState>(juniper::function<bool(Io::pinState)>([=](Io::pinState currState) mutable -> bool { 
+        return Signal::toUnit<Io::pinState>(Signal::filter<Io::pinState>([=](Io::pinState currState) mutable -> bool { 
             return (([&]() -> bool {
                 auto guid108 = (([&]() -> bool {
                     auto guid109 = (Prelude::tuple2<Io::pinState,Io::pinState>{currState, (*((prevState).get()))});
@@ -3468,13 +4586,13 @@ namespace Io {
                 (*((Io::pinState*) (prevState.get())) = currState);
                 return ret;
             })());
-         }), sig));
+         }, juniper::move(sig)));
     }
 }
 
 namespace Io {
     Prelude::sig<Prelude::unit> fallingEdge(Prelude::sig<Io::pinState> sig, juniper::shared_ptr<Io::pinState> prevState) {
-        return Signal::toUnit<Io::pinState>(Signal::filter<Io::pinState>(juniper::function<bool(Io::pinState)>([=](Io::pinState currState) mutable -> bool { 
+        return Signal::toUnit<Io::pinState>(Signal::filter<Io::pinState>([=](Io::pinState currState) mutable -> bool { 
             return (([&]() -> bool {
                 auto guid110 = (([&]() -> bool {
                     auto guid111 = (Prelude::tuple2<Io::pinState,Io::pinState>{currState, (*((prevState).get()))});
@@ -3498,13 +4616,13 @@ namespace Io {
                 (*((Io::pinState*) (prevState.get())) = currState);
                 return ret;
             })());
-         }), sig));
+         }, juniper::move(sig)));
     }
 }
 
 namespace Io {
     Prelude::sig<Io::pinState> edge(Prelude::sig<Io::pinState> sig, juniper::shared_ptr<Io::pinState> prevState) {
-        return Signal::filter<Io::pinState>(juniper::function<bool(Io::pinState)>([=](Io::pinState currState) mutable -> bool { 
+        return Signal::filter<Io::pinState>([=](Io::pinState currState) mutable -> bool { 
             return (([&]() -> bool {
                 auto guid112 = (([&]() -> bool {
                     auto guid113 = (Prelude::tuple2<Io::pinState,Io::pinState>{currState, (*((prevState).get()))});
@@ -3533,7 +4651,7 @@ namespace Io {
                 (*((Io::pinState*) (prevState.get())) = currState);
                 return ret;
             })());
-         }), sig);
+         }, juniper::move(sig));
     }
 }
 
@@ -3700,11 +4818,12 @@ namespace Time {
 
 namespace Time {
     juniper::shared_ptr<Time::timerState> state() {
-        return (juniper::shared_ptr<Time::timerState>(new Time::timerState((([&]() -> Time::timerState{
+        return (juniper::make_shared<Time::timerState>((([&]() -> Time::timerState{
             Time::timerState guid121;
             guid121.lastPulse = 0;
+            guid121.timer = 0;
             return guid121;
-        })()))));
+        })())));
     }
 }
 
@@ -3717,26 +4836,121 @@ namespace Time {
             }
             auto t = guid122;
             
-            auto guid123 = ((interval == 0) ? 
-                t
-            :
-                ((t / interval) * interval));
+            auto guid123 = false;
             if (!(true)) {
                 juniper::quit<Prelude::unit>();
             }
-            auto lastWindow = guid123;
+            auto fired = guid123;
             
-            return ((((*((state).get()))).lastPulse >= lastWindow) ? 
-                signal<uint32_t>(nothing<uint32_t>())
-            :
+            (([&]() -> Prelude::unit {
+                Time::timerState &s = *((Time::timerState*) (state.get()));
+                if (s.timer == 0) {
+                    s.timer = juniper::timer_subscribe(interval, t);
+                }
+                if (s.timer != 0) {
+                    juniper::timer_poll(t);
+                    fired = juniper::timer_take(s.timer);
+                } else {
+                    // The timer service is full, so fall back to finding
+                    // the interval window the clock is in
+                    uint32_t lastWindow = interval == 0 ? t : (t / interval) * interval;
+                    fired = s.lastPulse < lastWindow;
+                    juniper::wake_at(lastWindow + interval);
+                };
+                return {};
+            })());
+            return (fired ? 
                 (([&]() -> Prelude::sig<uint32_t> {
                     (*((Time::timerState*) (state.get())) = (([&]() -> Time::timerState{
                         Time::timerState guid124;
                         guid124.lastPulse = t;
+                        guid124.timer = ((*((state).get()))).timer;
                         return guid124;
                     })()));
                     return signal<uint32_t>(just<uint32_t>(t));
-                })()));
+                })())
+            :
+                signal<uint32_t>(nothing<uint32_t>()));
+        })());
+    }
+}
+
+// Frees the timer that every subscribed for state. The next call to every
+// with state subscribes a new one.
+namespace Time {
+    Prelude::unit cancel(juniper::shared_ptr<Time::timerState> state) {
+        return (([&]() -> Prelude::unit {
+            Time::timerState &s = *((Time::timerState*) (state.get()));
+            if (s.timer != 0) {
+                juniper::timer_unsubscribe(s.timer);
+                s.timer = 0;
+            }
+            return {};
+        })());
+    }
+}
+
+// A clock domain ticks every period ms. Signals that are evaluated only on
+// its ticks run at the domain's rate however often the loop runs, and
+// Signal::sampleHold and Signal::gate cross between domains.
+namespace Time {
+    Time::domainState domain(uint32_t period) {
+        return (([&]() -> Time::domainState{
+            Time::domainState guid269;
+            guid269.period = period;
+            guid269.nextTick = 0;
+            guid269.started = false;
+            return guid269;
+        })());
+    }
+}
+
+// Emits the time on the first call at or after each tick of the domain.
+// The ticks stay on the domain's grid unless a whole period is missed. A
+// call between ticks asks for a wake at the next one, so that whatever the
+// domain gates is not left waiting for an unrelated wake.
+namespace Time {
+    Prelude::sig<uint32_t> tick(juniper::shared_ptr<Time::domainState> domain) {
+        return (([&]() -> Prelude::sig<uint32_t> {
+            auto guid270 = now();
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto t = guid270;
+            
+            auto guid271 = false;
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto due = guid271;
+            
+            (([&]() -> Prelude::unit {
+                Time::domainState &d = *((Time::domainState*) (domain.get()));
+                uint32_t late = t - d.nextTick;
+                if (!d.started || ((int32_t) late >= 0)) {
+                    d.nextTick = (d.started && (late < d.period)) ? (d.nextTick + d.period) : (t + d.period);
+                    d.started = true;
+                    due = true;
+                } else {
+                    juniper::wake_at(d.nextTick);
+                };
+                return {};
+            })());
+            return (due ? 
+                signal<uint32_t>(just<uint32_t>(t))
+            :
+                signal<uint32_t>(nothing<uint32_t>()));
+        })());
+    }
+}
+
+// Asks for the loop to run again by the domain's next tick, for domains
+// that must keep ticking, such as the render domain while a mode animates
+namespace Time {
+    Prelude::unit demand(juniper::shared_ptr<Time::domainState> domain) {
+        return (([&]() -> Prelude::unit {
+            juniper::wake_at(((*((domain).get()))).nextTick);
+            return {};
         })());
     }
 }
@@ -4216,20 +5430,27 @@ namespace Math {
 
 namespace Button {
     juniper::shared_ptr<Button::buttonState> state() {
-        return (juniper::shared_ptr<Button::buttonState>(new Button::buttonState((([&]() -> Button::buttonState{
+        return (juniper::make_shared<Button::buttonState>((([&]() -> Button::buttonState{
             Button::buttonState guid148;
             guid148.actualState = Io::low();
             guid148.lastState = Io::low();
             guid148.lastDebounceTime = 0;
             return guid148;
-        })()))));
+        })())));
     }
 }
 
 namespace Button {
-    Prelude::sig<Io::pinState> debounceDelay(Prelude::sig<Io::pinState> incoming, uint16_t delay, juniper::shared_ptr<Button::buttonState> buttonState) {
-        return Signal::map<Io::pinState, Io::pinState>(juniper::function<Io::pinState(Io::pinState)>([=](Io::pinState currentState) mutable -> Io::pinState { 
+    Prelude::sig<Io::pinState> debounceDelayAt(Prelude::sig<Prelude::tuple2<Io::pinState,uint32_t>> incoming, uint16_t delay, juniper::shared_ptr<Button::buttonState> buttonState) {
+        return Signal::map<Prelude::tuple2<Io::pinState,uint32_t>, Io::pinState>([=](Prelude::tuple2<Io::pinState,uint32_t> sample) mutable -> Io::pinState { 
             return (([&]() -> Io::pinState {
+                auto guid293 = sample;
+                if (!(true)) {
+                    juniper::quit<Prelude::unit>();
+                }
+                auto currentTime = (guid293).e2;
+                auto currentState = (guid293).e1;
+                
                 auto guid149 = (*((buttonState).get()));
                 if (!(true)) {
                     juniper::quit<Prelude::unit>();
@@ -4244,13 +5465,17 @@ namespace Button {
                             Button::buttonState guid150;
                             guid150.actualState = actualState;
                             guid150.lastState = currentState;
-                            guid150.lastDebounceTime = Time::now();
+                            guid150.lastDebounceTime = currentTime;
                             return guid150;
                         })()));
+                        (([&]() -> Prelude::unit {
+                            juniper::wake_at(currentTime + delay + 1);
+                            return {};
+                        })());
                         return actualState;
                     })())
                 :
-                    (((currentState != actualState) && ((Time::now() - ((*((buttonState).get()))).lastDebounceTime) > delay)) ? 
+                    (((currentState != actualState) && ((currentTime - ((*((buttonState).get()))).lastDebounceTime) > delay)) ? 
                         (([&]() -> Io::pinState {
                             (*((Button::buttonState*) (buttonState.get())) = (([&]() -> Button::buttonState{
                                 Button::buttonState guid151;
@@ -4270,16 +5495,37 @@ namespace Button {
                                 guid152.lastDebounceTime = lastDebounceTime;
                                 return guid152;
                             })()));
+                            ((currentState != actualState) ? 
+                                (([&]() -> Prelude::unit {
+                                    juniper::wake_at(lastDebounceTime + delay + 1);
+                                    return {};
+                                })())
+                            :
+                                Prelude::unit());
                             return actualState;
                         })())));
             })());
-         }), incoming);
+         }, juniper::move(incoming));
+    }
+}
+
+namespace Button {
+    Prelude::sig<Io::pinState> debounceDelay(Prelude::sig<Io::pinState> incoming, uint16_t delay, juniper::shared_ptr<Button::buttonState> buttonState) {
+        return debounceDelayAt(Signal::map<Io::pinState, Prelude::tuple2<Io::pinState,uint32_t>>([=](Io::pinState currentState) mutable -> Prelude::tuple2<Io::pinState,uint32_t> { 
+            return (Prelude::tuple2<Io::pinState,uint32_t>{currentState, (uint32_t) Time::now()});
+         }, juniper::move(incoming)), delay, juniper::move(buttonState));
+    }
+}
+
+namespace Button {
+    Prelude::sig<Io::pinState> debounceAt(Prelude::sig<Prelude::tuple2<Io::pinState,uint32_t>> incoming, juniper::shared_ptr<Button::buttonState> buttonState) {
+        return debounceDelayAt(juniper::move(incoming), 50, juniper::move(buttonState));
     }
 }
 
 namespace Button {
     Prelude::sig<Io::pinState> debounce(Prelude::sig<Io::pinState> incoming, juniper::shared_ptr<Button::buttonState> buttonState) {
-        return debounceDelay(incoming, 50, buttonState);
+        return debounceDelay(juniper::move(incoming), 50, juniper::move(buttonState));
     }
 }
 
@@ -4311,15 +5557,15 @@ namespace Vector {
 
 namespace Vector {
     template<typename t682, int c71>
-    t682 get(uint32_t i, Vector::vector<t682, c71> v) {
+    t682 get(uint32_t i, const Vector::vector<t682, c71>& v) {
         return (([&]() -> t682 {
             auto n = c71;
             return (([&]() -> t682 {
-                auto guid154 = v;
+                const auto& guid154 = v;
                 if (!(true)) {
                     juniper::quit<Prelude::unit>();
                 }
-                auto data = (guid154).data;
+                const auto& data = (guid154).data;
                 
                 return (data)[i];
             })());
@@ -4329,7 +5575,7 @@ namespace Vector {
 
 namespace Vector {
     template<typename t684, int c72>
-    Vector::vector<t684, c72> add(Vector::vector<t684, c72> v1, Vector::vector<t684, c72> v2) {
+    Vector::vector<t684, c72> add(const Vector::vector<t684, c72>& v1, const Vector::vector<t684, c72>& v2) {
         return (([&]() -> Vector::vector<t684, c72> {
             auto n = c72;
             return (([&]() -> Vector::vector<t684, c72> {
@@ -4369,7 +5615,7 @@ namespace Vector {
 
 namespace Vector {
     template<typename t695, int c77>
-    Vector::vector<t695, c77> subtract(Vector::vector<t695, c77> v1, Vector::vector<t695, c77> v2) {
+    Vector::vector<t695, c77> subtract(const Vector::vector<t695, c77>& v1, const Vector::vector<t695, c77>& v2) {
         return (([&]() -> Vector::vector<t695, c77> {
             auto n = c77;
             return (([&]() -> Vector::vector<t695, c77> {
@@ -4398,7 +5644,7 @@ namespace Vector {
 
 namespace Vector {
     template<typename t703, int c81>
-    Vector::vector<t703, c81> scale(t703 scalar, Vector::vector<t703, c81> v) {
+    Vector::vector<t703, c81> scale(t703 scalar, const Vector::vector<t703, c81>& v) {
         return (([&]() -> Vector::vector<t703, c81> {
             auto n = c81;
             return (([&]() -> Vector::vector<t703, c81> {
@@ -4427,7 +5673,7 @@ namespace Vector {
 
 namespace Vector {
     template<typename t709, int c84>
-    t709 dot(Vector::vector<t709, c84> v1, Vector::vector<t709, c84> v2) {
+    t709 dot(const Vector::vector<t709, c84>& v1, const Vector::vector<t709, c84>& v2) {
         return (([&]() -> t709 {
             auto n = c84;
             return (([&]() -> t709 {
@@ -4456,7 +5702,7 @@ namespace Vector {
 
 namespace Vector {
     template<typename t715, int c87>
-    t715 magnitude2(Vector::vector<t715, c87> v) {
+    t715 magnitude2(const Vector::vector<t715, c87>& v) {
         return (([&]() -> t715 {
             auto n = c87;
             return (([&]() -> t715 {
@@ -4485,7 +5731,7 @@ namespace Vector {
 
 namespace Vector {
     template<typename t721, int c90>
-    double magnitude(Vector::vector<t721, c90> v) {
+    double magnitude(const Vector::vector<t721, c90>& v) {
         return (([&]() -> double {
             auto n = c90;
             return sqrt_(magnitude2<t721, c90>(v));
@@ -4495,7 +5741,7 @@ namespace Vector {
 
 namespace Vector {
     template<typename t727, int c91>
-    Vector::vector<t727, c91> multiply(Vector::vector<t727, c91> u, Vector::vector<t727, c91> v) {
+    Vector::vector<t727, c91> multiply(const Vector::vector<t727, c91>& u, const Vector::vector<t727, c91>& v) {
         return (([&]() -> Vector::vector<t727, c91> {
             auto n = c91;
             return (([&]() -> Vector::vector<t727, c91> {
@@ -4524,7 +5770,7 @@ namespace Vector {
 
 namespace Vector {
     template<typename t735, int c95>
-    Vector::vector<t735, c95> normalize(Vector::vector<t735, c95> v) {
+    Vector::vector<t735, c95> normalize(const Vector::vector<t735, c95>& v) {
         return (([&]() -> Vector::vector<t735, c95> {
             auto n = c95;
             return (([&]() -> Vector::vector<t735, c95> {
@@ -4564,7 +5810,7 @@ namespace Vector {
 
 namespace Vector {
     template<typename t743, int c98>
-    double angle(Vector::vector<t743, c98> v1, Vector::vector<t743, c98> v2) {
+    double angle(const Vector::vector<t743, c98>& v1, const Vector::vector<t743, c98>& v2) {
         return (([&]() -> double {
             auto n = c98;
             return acos_((dot<t743, c98>(v1, v2) / sqrt_((magnitude2<t743, c98>(v1) * magnitude2<t743, c98>(v2)))));
@@ -4574,7 +5820,7 @@ namespace Vector {
 
 namespace Vector {
     template<typename t781>
-    Vector::vector<t781, 3> cross(Vector::vector<t781, 3> u, Vector::vector<t781, 3> v) {
+    Vector::vector<t781, 3> cross(const Vector::vector<t781, 3>& u, const Vector::vector<t781, 3>& v) {
         return (([&]() -> Vector::vector<t781, 3>{
             Vector::vector<t781, 3> guid178;
             guid178.data = (juniper::array<t781, 3> { {((((u).data)[1] * ((v).data)[2]) - (((u).data)[2] * ((v).data)[1])), ((((u).data)[2] * ((v).data)[0]) - (((u).data)[0] * ((v).data)[2])), ((((u).data)[0] * ((v).data)[1]) - (((u).data)[1] * ((v).data)[0]))} });
@@ -4585,7 +5831,7 @@ namespace Vector {
 
 namespace Vector {
     template<typename t783, int c111>
-    Vector::vector<t783, c111> project(Vector::vector<t783, c111> a, Vector::vector<t783, c111> b) {
+    Vector::vector<t783, c111> project(const Vector::vector<t783, c111>& a, const Vector::vector<t783, c111>& b) {
         return (([&]() -> Vector::vector<t783, c111> {
             auto n = c111;
             return (([&]() -> Vector::vector<t783, c111> {
@@ -4603,7 +5849,7 @@ namespace Vector {
 
 namespace Vector {
     template<typename t793, int c112>
-    Vector::vector<t793, c112> projectPlane(Vector::vector<t793, c112> a, Vector::vector<t793, c112> m) {
+    Vector::vector<t793, c112> projectPlane(const Vector::vector<t793, c112>& a, const Vector::vector<t793, c112>& m) {
         return (([&]() -> Vector::vector<t793, c112> {
             auto n = c112;
             return subtract<t793, c112>(a, project<t793, c112>(a, m));
@@ -4613,74 +5859,115 @@ namespace Vector {
 
 namespace CharList {
     template<int c113>
-    Prelude::list<uint8_t, c113> toUpper(Prelude::list<uint8_t, c113> str) {
-        return List::map<uint8_t, uint8_t, c113>(juniper::function<uint8_t(uint8_t)>([=](uint8_t c) mutable -> uint8_t { 
+    Prelude::list<uint8_t, c113> toUpper(const Prelude::list<uint8_t, c113>& str) {
+        return List::map<uint8_t, uint8_t, c113>([=](uint8_t c) mutable -> uint8_t { 
             return (((c >= ((uint8_t) 97)) && (c <= ((uint8_t) 122))) ? 
                 (c - ((uint8_t) 32))
             :
                 c);
-         }), str);
+         }, str);
     }
 }
 
 namespace CharList {
     template<int c114>
-    Prelude::list<uint8_t, c114> toLower(Prelude::list<uint8_t, c114> str) {
-        return List::map<uint8_t, uint8_t, c114>(juniper::function<uint8_t(uint8_t)>([=](uint8_t c) mutable -> uint8_t { 
+    Prelude::list<uint8_t, c114> toLower(const Prelude::list<uint8_t, c114>& str) {
+        return List::map<uint8_t, uint8_t, c114>([=](uint8_t c) mutable -> uint8_t { 
             return (((c >= ((uint8_t) 65)) && (c <= ((uint8_t) 90))) ? 
                 (c + ((uint8_t) 32))
             :
                 c);
-         }), str);
+         }, str);
     }
 }
 
 namespace FastLed {
-    FastLed::fastLedStrip make(uint16_t numLeds) {
-        return (([&]() -> FastLed::fastLedStrip {
-            auto guid180 = juniper::shared_ptr<void>(NULL);
-            if (!(true)) {
-                juniper::quit<Prelude::unit>();
-            }
-            auto p = guid180;
-            
-            (([&]() -> Prelude::unit {
-                
-    CRGB *leds = new CRGB[numLeds];
-    p.set((void *) leds);
-    FastLED.addLeds<WS2812, 6, RGB>(leds, numLeds);
-    
-                return {};
-            })());
-            Io::setPinMode(6, Io::output());
-            return (([&]() -> FastLed::fastLedStrip{
-                FastLed::fastLedStrip guid181;
-                guid181.ptr = p;
-                return guid181;
-            })());
+    uint32_t minRefreshInterval = 1000;
+}
+
+namespace FastLed {
+    juniper::static_ref<bool> dirty = (juniper::static_ref<bool>(true));
+}
+
+namespace FastLed {
+    juniper::static_ref<uint32_t> lastShow = (juniper::static_ref<uint32_t>(0));
+}
+
+namespace FastLed {
+    int32_t backgroundLayer = (([]() -> int32_t {
+        auto guid276 = 0;
+        if (!(true)) {
+            juniper::quit<Prelude::unit>();
+        }
+        auto l = guid276;
+        
+        (([&]() -> Prelude::unit {
+            l = layers::background;
+            return {};
         })());
-    }
+        return l;
+    })());
 }
 
 namespace FastLed {
-    template<typename t822, typename t823>
-    Prelude::unit setLedColor(uint16_t n, t822 c, t823 strip) {
-        return (([&]() -> Prelude::unit {
-            auto guid182 = strip;
-            if (!(true)) {
-                juniper::quit<Prelude::unit>();
-            }
-            auto p = (guid182).ptr;
-            
-            auto guid183 = (strip).ptr;
-            if (!(true)) {
-                juniper::quit<Prelude::unit>();
-            }
-            auto p = guid183;
-            
-            auto guid184 = (c).r;
-            if (!(true)) {
-                juniper::quit<Prelude::unit>();
+    int32_t progressLayer = (([]() -> int32_t {
+        auto guid277 = 0;
+        if (!(true)) {
+            juniper::quit<Prelude::unit>();
+        }
+        auto l = guid277;
+        
+        (([&]() -> Prelude::unit {
+            l = layers::progress;
+            return {};
+        })());
+        return l;
+    })());
+}
+
+namespace FastLed {
+    int32_t cursorLayer = (([]() -> int32_t {
+        auto guid278 = 0;
+        if (!(true)) {
+            juniper::quit<Prelude::unit>();
+        }
+        auto l = guid278;
+        
+        (([&]() -> Prelude::unit {
+            l = layers::cursor;
+            return {};
+        })());
+        return l;
+    })());
+}
+
+namespace FastLed {
+    Prelude::unit begin() {
+        return (([&]() -> Prelude::unit {
+            auto guid180 = 0;
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto pin = guid180;
+            
+            (([&]() -> Prelude::unit {
+                
+    strip::hourglass::begin();
+    pin = strip::hourglass::pin;
+    
+                return {};
+            })());
+            return Io::setPinMode(pin, Io::output());
+        })());
+    }
+}
+
+namespace FastLed {
+    Prelude::unit setLedColor(uint16_t n, FastLed::color c) {
+        return (([&]() -> Prelude::unit {
+            auto guid184 = (c).r;
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
             }
             auto r = guid184;
             
@@ -4696,24 +5983,35 @@ namespace FastLed {
             }
             auto b = guid186;
             
-            return (([&]() -> Prelude::unit {
-                ((CRGB *) p.get())[n] = CRGB(g, r, b);
+            auto guid274 = false;
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto changed = guid274;
+            
+            (([&]() -> Prelude::unit {
+                
+    CRGB &led = strip::hourglass::leds[n];
+    CRGB next = CRGB(r, g, b);
+    changed = led != next;
+    led = next;
+    
                 return {};
             })());
+            return (changed ? 
+                (([&]() -> Prelude::unit {
+                    (*((bool*) (dirty.get())) = true);
+                    return Prelude::unit();
+                })())
+            :
+                Prelude::unit());
         })());
     }
 }
 
 namespace FastLed {
-    template<typename t829>
-    FastLed::color getLedColor(uint16_t n, t829 strip) {
+    FastLed::color getLedColor(uint16_t n) {
         return (([&]() -> FastLed::color {
-            auto guid187 = strip;
-            if (!(true)) {
-                juniper::quit<Prelude::unit>();
-            }
-            auto p = (guid187).ptr;
-            
             auto guid188 = 0;
             if (!(true)) {
                 juniper::quit<Prelude::unit>();
@@ -4734,7 +6032,7 @@ namespace FastLed {
             
             (([&]() -> Prelude::unit {
                 
-    CRGB c = ((CRGB *) p.get())[n];
+    CRGB c = strip::hourglass::leds[n];
     r = c.r;
     g = c.g;
     b = c.b;
@@ -4743,8 +6041,8 @@ namespace FastLed {
             })());
             return (([&]() -> FastLed::color{
                 FastLed::color guid191;
-                guid191.r = g;
-                guid191.g = r;
+                guid191.r = r;
+                guid191.g = g;
                 guid191.b = b;
                 return guid191;
             })());
@@ -4753,16 +6051,198 @@ namespace FastLed {
 }
 
 namespace FastLed {
-    Prelude::unit show() {
+    Prelude::unit beginLayer(uint8_t layer) {
+        return (([&]() -> Prelude::unit {
+            layers::begin(layer);
+            return {};
+        })());
+    }
+}
+
+namespace FastLed {
+    Prelude::unit setLayerColor(uint8_t layer, uint16_t n, FastLed::color c) {
         return (([&]() -> Prelude::unit {
-            FastLED.show();
+            auto guid279 = (c).r;
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto r = guid279;
+            
+            auto guid280 = (c).g;
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto g = guid280;
+            
+            auto guid281 = (c).b;
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto b = guid281;
+            
+            return (([&]() -> Prelude::unit {
+                layers::set(layer, n, CRGB(r, g, b));
+                return {};
+            })());
+        })());
+    }
+}
+
+namespace FastLed {
+    Prelude::unit fill(uint8_t layer, FastLed::range r, FastLed::color c) {
+        return (([&]() -> Prelude::unit {
+            layers::fill(layer, r.first, r.last, CRGB(c.r, c.g, c.b));
+            return {};
+        })());
+    }
+}
+
+namespace FastLed {
+    Prelude::unit fillGradient(uint8_t layer, FastLed::range r, FastLed::color c1, FastLed::color c2) {
+        return (([&]() -> Prelude::unit {
+            layers::fillGradient(layer, r.first, r.last, CRGB(c1.r, c1.g, c1.b), CRGB(c2.r, c2.g, c2.b));
+            return {};
+        })());
+    }
+}
+
+namespace FastLed {
+    Prelude::unit copyRange(uint8_t layer, FastLed::range r, uint16_t dest) {
+        return (([&]() -> Prelude::unit {
+            layers::copyRange(layer, r.first, r.last, dest);
+            return {};
+        })());
+    }
+}
+
+namespace FastLed {
+    Prelude::unit scaleRange(uint8_t layer, FastLed::range r, uint8_t factor) {
+        return (([&]() -> Prelude::unit {
+            layers::scaleRange(layer, r.first, r.last, factor);
+            return {};
+        })());
+    }
+}
+
+namespace FastLed {
+    Prelude::unit endLayer(uint8_t layer) {
+        return (([&]() -> Prelude::unit {
+            layers::end(layer);
+            return {};
+        })());
+    }
+}
+
+namespace FastLed {
+    Prelude::unit setBrightness(uint8_t brightness) {
+        return (([&]() -> Prelude::unit {
+            layers::setBrightness(brightness);
             return {};
         })());
     }
 }
 
+namespace FastLed {
+    Prelude::unit resetLayers() {
+        return (([&]() -> Prelude::unit {
+            layers::reset();
+            return {};
+        })());
+    }
+}
+
+namespace FastLed {
+    Prelude::unit composite() {
+        return (([&]() -> Prelude::unit {
+            auto guid284 = false;
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto changed = guid284;
+            
+            (([&]() -> Prelude::unit {
+                changed = layers::composite(strip::hourglass::leds);
+                return {};
+            })());
+            return (changed ? 
+                (([&]() -> Prelude::unit {
+                    (*((bool*) (dirty.get())) = true);
+                    return Prelude::unit();
+                })())
+            :
+                Prelude::unit());
+        })());
+    }
+}
+
+namespace FastLed {
+    FastLed::color blend(FastLed::color c1, FastLed::color c2, uint8_t amount) {
+        return (([&]() -> FastLed::color {
+            auto guid289 = 0;
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto r = guid289;
+            
+            auto guid290 = 0;
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto g = guid290;
+            
+            auto guid291 = 0;
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto b = guid291;
+            
+            (([&]() -> Prelude::unit {
+                
+    CRGB c = colormath::blend(CRGB(c1.r, c1.g, c1.b), CRGB(c2.r, c2.g, c2.b), amount);
+    r = c.r;
+    g = c.g;
+    b = c.b;
+    
+                return {};
+            })());
+            return (([&]() -> FastLed::color{
+                FastLed::color guid292;
+                guid292.r = r;
+                guid292.g = g;
+                guid292.b = b;
+                return guid292;
+            })());
+        })());
+    }
+}
+
+namespace FastLed {
+    Prelude::unit show() {
+        return (([&]() -> Prelude::unit {
+            auto guid275 = Time::now();
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto now = guid275;
+            
+            return (((*((dirty).get())) || ((now - (*((lastShow).get()))) >= minRefreshInterval)) ? 
+                (([&]() -> Prelude::unit {
+                    (([&]() -> Prelude::unit {
+                        FastLED.show();
+                        return {};
+                    })());
+                    (*((bool*) (dirty.get())) = false);
+                    (*((uint32_t*) (lastShow.get())) = now);
+                    return Prelude::unit();
+                })())
+            :
+                Prelude::unit());
+        })());
+    }
+}
+
 namespace Accelerometer {
-    int32_t xPin = (([&]() -> int32_t {
+    int32_t xPin = (([]() -> int32_t {
         auto guid192 = 0;
         if (!(true)) {
             juniper::quit<Prelude::unit>();
@@ -4778,7 +6258,7 @@ namespace Accelerometer {
 }
 
 namespace Accelerometer {
-    int32_t yPin = (([&]() -> int32_t {
+    int32_t yPin = (([]() -> int32_t {
         auto guid193 = 0;
         if (!(true)) {
             juniper::quit<Prelude::unit>();
@@ -4794,7 +6274,7 @@ namespace Accelerometer {
 }
 
 namespace Accelerometer {
-    int32_t zPin = (([&]() -> int32_t {
+    int32_t zPin = (([]() -> int32_t {
         auto guid194 = 0;
         if (!(true)) {
             juniper::quit<Prelude::unit>();
@@ -4809,6 +6289,18 @@ namespace Accelerometer {
     })());
 }
 
+namespace Accelerometer {
+    juniper::static_ref<juniper::ring<int32_t, 4>> xSamples = (juniper::static_ref<juniper::ring<int32_t, 4>>(juniper::ring<int32_t, 4>()));
+}
+
+namespace Accelerometer {
+    juniper::static_ref<juniper::ring<int32_t, 4>> ySamples = (juniper::static_ref<juniper::ring<int32_t, 4>>(juniper::ring<int32_t, 4>()));
+}
+
+namespace Accelerometer {
+    juniper::static_ref<juniper::ring<int32_t, 4>> zSamples = (juniper::static_ref<juniper::ring<int32_t, 4>>(juniper::ring<int32_t, 4>()));
+}
+
 namespace Accelerometer {
     int32_t axisToPin(Accelerometer::axis a) {
         return (([&]() -> int32_t {
@@ -4857,6 +6349,30 @@ namespace Accelerometer {
     }
 }
 
+namespace Accelerometer {
+    juniper::shared_ptr<juniper::ring<int32_t, 4>> axisToSamples(Accelerometer::axis a) {
+        return (([&]() -> juniper::shared_ptr<juniper::ring<int32_t, 4>> {
+            auto guid305 = a;
+            return ((((guid305).tag == 0) && true) ? 
+                (([&]() -> juniper::shared_ptr<juniper::ring<int32_t, 4>> {
+                    return xSamples;
+                })())
+            :
+                ((((guid305).tag == 1) && true) ? 
+                    (([&]() -> juniper::shared_ptr<juniper::ring<int32_t, 4>> {
+                        return ySamples;
+                    })())
+                :
+                    ((((guid305).tag == 2) && true) ? 
+                        (([&]() -> juniper::shared_ptr<juniper::ring<int32_t, 4>> {
+                            return zSamples;
+                        })())
+                    :
+                        juniper::quit<juniper::shared_ptr<juniper::ring<int32_t, 4>>>())));
+        })());
+    }
+}
+
 namespace Accelerometer {
     int32_t readRaw(Accelerometer::axis a) {
         return (([&]() -> int32_t {
@@ -4868,24 +6384,17 @@ namespace Accelerometer {
             
             Io::anaRead(pin);
             Time::wait(1);
-            auto guid198 = 0;
+            int32_t guid268 = Io::anaRead(pin);
             if (!(true)) {
                 juniper::quit<Prelude::unit>();
             }
-            auto total = guid198;
+            auto raw = guid268;
             
             (([&]() -> Prelude::unit {
-                uint8_t guid199 = 0;
-                uint8_t guid200 = 3;
-                for (uint8_t i = guid199; i <= guid200; i++) {
-                    (([&]() -> Prelude::unit {
-                        (total = (total + Io::anaRead(pin)));
-                        return Prelude::unit();
-                    })());
-                }
+                TRACE_ANALOG(pin, raw);
                 return {};
             })());
-            return (total / 4);
+            return raw;
         })());
     }
 }
@@ -4900,7 +6409,19 @@ namespace Accelerometer {
             auto max = (guid201).e2;
             auto min = (guid201).e1;
             
-            return Math::mapRange(readRaw(a), min, max, -(1000), 1000);
+            auto guid306 = Signal::history<int32_t, 4>(signal<int32_t>(just<int32_t>(readRaw(a))), axisToSamples(a));
+            return (((((guid306).signal).tag == 0) && true) ? 
+                (([&]() -> double {
+                    auto samples = ((guid306).signal).just;
+                    return Math::mapRange(List::average<int32_t, 4>(samples), min, max, -(1000), 1000);
+                })())
+            :
+                (true ? 
+                    (([&]() -> double {
+                        return 0.0;
+                    })())
+                :
+                    juniper::quit<double>()));
         })());
     }
 }
@@ -4957,9 +6478,9 @@ namespace Accelerometer {
 
 namespace IoExt {
     Prelude::sig<Io::pinState> every(uint32_t interval, juniper::shared_ptr<Time::timerState> tState, juniper::shared_ptr<Io::pinState> outState) {
-        return Signal::foldP<uint32_t, Io::pinState>(juniper::function<Io::pinState(uint32_t,Io::pinState)>([=](uint32_t currentTime, Io::pinState lastState) mutable -> Io::pinState { 
+        return Signal::foldP<uint32_t, Io::pinState>([=](uint32_t currentTime, Io::pinState lastState) mutable -> Io::pinState { 
             return Io::toggle(lastState);
-         }), outState, Time::every(interval, tState));
+         }, juniper::move(outState), Time::every(interval, juniper::move(tState)));
     }
 }
 
@@ -4986,7 +6507,7 @@ namespace SignalExt {
 }
 
 namespace SignalExt {
-    template<typename t935>
+    template<typename t944>
     Prelude::sig<t944> unmeta(Prelude::sig<Prelude::maybe<t944>> sigA) {
         return (([&]() -> Prelude::sig<t944> {
             auto guid206 = sigA;
@@ -5009,26 +6530,26 @@ namespace SignalExt {
 namespace SignalExt {
     template<typename t955, typename t956>
     Prelude::sig<Prelude::tuple2<t955,t956>> zip(Prelude::sig<t955> sigA, Prelude::sig<t956> sigB, juniper::shared_ptr<Prelude::tuple2<t955,t956>> state) {
-        return Signal::map2<t955, t956, Prelude::tuple2<t955,t956>>(juniper::function<Prelude::tuple2<t955,t956>(t955,t956)>([=](t955 valA, t956 valB) mutable -> Prelude::tuple2<t955,t956> { 
+        return Signal::map2<t955, t956, Prelude::tuple2<t955,t956>>([=](t955 valA, t956 valB) mutable -> Prelude::tuple2<t955,t956> { 
             return (Prelude::tuple2<t955,t956>{valA, valB});
-         }), sigA, sigB, state);
+         }, juniper::move(sigA), juniper::move(sigB), juniper::move(state));
     }
 }
 
 namespace SignalExt {
     template<typename t963, typename t969>
     Prelude::sig<t963> toggle(t963 val1, t963 val2, juniper::shared_ptr<t963> state, Prelude::sig<t969> incoming) {
-        return Signal::foldP<t969, t963>(juniper::function<t963(t969,t963)>([=](t969 event, t963 prevVal) mutable -> t963 { 
+        return Signal::foldP<t969, t963>([=](t969 event, t963 prevVal) mutable -> t963 { 
             return ((prevVal == val1) ? 
                 val2
             :
                 val1);
-         }), state, incoming);
+         }, juniper::move(state), juniper::move(incoming));
     }
 }
 
 namespace Constants {
-    FastLed::color blank = (([&]() -> FastLed::color{
+    FastLed::color blank = (([]() -> FastLed::color{
         FastLed::color guid207;
         guid207.r = 0;
         guid207.g = 0;
@@ -5038,7 +6559,7 @@ namespace Constants {
 }
 
 namespace Constants {
-    FastLed::color red = (([&]() -> FastLed::color{
+    FastLed::color red = (([]() -> FastLed::color{
         FastLed::color guid208;
         guid208.r = 255;
         guid208.g = 0;
@@ -5048,7 +6569,7 @@ namespace Constants {
 }
 
 namespace Constants {
-    FastLed::color green = (([&]() -> FastLed::color{
+    FastLed::color green = (([]() -> FastLed::color{
         FastLed::color guid209;
         guid209.r = 0;
         guid209.g = 255;
@@ -5058,7 +6579,7 @@ namespace Constants {
 }
 
 namespace Constants {
-    FastLed::color blue = (([&]() -> FastLed::color{
+    FastLed::color blue = (([]() -> FastLed::color{
         FastLed::color guid210;
         guid210.r = 0;
         guid210.g = 0;
@@ -5068,7 +6589,7 @@ namespace Constants {
 }
 
 namespace Constants {
-    FastLed::color white = (([&]() -> FastLed::color{
+    FastLed::color white = (([]() -> FastLed::color{
         FastLed::color guid211;
         guid211.r = 255;
         guid211.g = 255;
@@ -5078,7 +6599,7 @@ namespace Constants {
 }
 
 namespace Constants {
-    FastLed::color pink = (([&]() -> FastLed::color{
+    FastLed::color pink = (([]() -> FastLed::color{
         FastLed::color guid212;
         guid212.r = 255;
         guid212.g = 50;
@@ -5092,15 +6613,11 @@ namespace Constants {
 }
 
 namespace Constants {
-    int32_t numLeds = 33;
-}
-
-namespace Constants {
-    FastLed::fastLedStrip leds = FastLed::make(numLeds);
+    const int32_t numLeds = strip::hourglass::numLeds;
 }
 
 namespace Timing {
-    juniper::shared_ptr<int32_t> lastTime = (juniper::shared_ptr<int32_t>(new int32_t(0)));
+    juniper::static_ref<int32_t> lastTime = (juniper::static_ref<int32_t>(0));
 }
 
 namespace Timing {
@@ -5113,38 +6630,48 @@ namespace Timing {
 }
 
 namespace Timing {
-    template<typename t981, typename t982>
-    FastLed::color interpolate(t981 c1, t982 c2, float t) {
-        return (([&]() -> FastLed::color {
-            auto guid213 = c1;
-            if (!(true)) {
-                juniper::quit<Prelude::unit>();
-            }
-            auto b1 = (guid213).b;
-            auto g1 = (guid213).g;
-            auto r1 = (guid213).r;
-            
-            auto guid214 = c2;
-            if (!(true)) {
-                juniper::quit<Prelude::unit>();
-            }
-            auto b2 = (guid214).b;
-            auto g2 = (guid214).g;
-            auto r2 = (guid214).r;
-            
-            return (([&]() -> FastLed::color{
-                FastLed::color guid215;
-                guid215.r = ((t * r1) + ((1.000000 - t) * r2));
-                guid215.g = ((t * g1) + ((1.000000 - t) * g2));
-                guid215.b = ((t * b1) + ((1.000000 - t) * b2));
-                return guid215;
-            })());
-        })());
+    FastLed::color ledColor(int32_t i) {
+        return blend(green, red, ((i * 256) / numLeds));
+    }
+}
+
+namespace Timing {
+    int32_t drop(uint32_t elapsed, uint32_t totalTime) {
+        return ((totalTime > 0) ? 
+            (([&]() -> int32_t {
+                uint64_t guid301 = numLeds;
+                if (!(true)) {
+                    juniper::quit<Prelude::unit>();
+                }
+                auto leds = guid301;
+                
+                uint64_t guid302 = totalTime;
+                if (!(true)) {
+                    juniper::quit<Prelude::unit>();
+                }
+                auto total = guid302;
+                
+                uint64_t guid303 = elapsed;
+                if (!(true)) {
+                    juniper::quit<Prelude::unit>();
+                }
+                auto fallen = guid303;
+                
+                int32_t guid304 = (((((fallen * leds) * leds) + total) - 1) / total);
+                if (!(true)) {
+                    juniper::quit<Prelude::unit>();
+                }
+                auto d = guid304;
+                
+                return d;
+            })())
+        :
+            (numLeds * numLeds));
     }
 }
 
 namespace Timing {
-    Prelude::unit execute(juniper::shared_ptr<int32_t> timeRemaining, float totalTime) {
+    Prelude::unit execute(juniper::shared_ptr<int32_t> timeRemaining, int32_t totalTime) {
         return (([&]() -> Prelude::unit {
             auto guid216 = Time::now();
             if (!(true)) {
@@ -5160,85 +6687,94 @@ namespace Timing {
             
             (*((int32_t*) (timeRemaining.get())) = ((*((timeRemaining).get())) - deltaT));
             (*((int32_t*) (lastTime.get())) = currentTime);
-            auto guid218 = (*((timeRemaining).get()));
+            auto guid218 = (((*((timeRemaining).get())) < totalTime) ? 
+                drop((totalTime - (*((timeRemaining).get()))), totalTime)
+            :
+                0);
             if (!(true)) {
                 juniper::quit<Prelude::unit>();
             }
-            auto timeRemainingF = guid218;
+            auto dropped = guid218;
             
-            auto guid219 = totalTime;
+            auto guid219 = ((dropped <= numLeds) ? 
+                0
+            :
+                Math::clamp<int32_t>(((dropped - 2) / (numLeds - 1)), 0, numLeds));
             if (!(true)) {
                 juniper::quit<Prelude::unit>();
             }
-            auto totalTimeF = guid219;
+            auto settled = guid219;
             
-            auto guid220 = (timeRemainingF / totalTimeF);
+            beginLayer(progressLayer);
+            fillGradient(progressLayer, (([&]() -> FastLed::range{
+                FastLed::range guid220;
+                guid220.first = settled;
+                guid220.last = numLeds;
+                return guid220;
+            })()), ledColor(settled), ledColor((numLeds - 1)));
+            auto guid221 = (settled - 1);
             if (!(true)) {
                 juniper::quit<Prelude::unit>();
             }
-            auto tPrime = guid220;
+            auto falling = guid221;
             
-            auto guid221 = numLeds;
+            auto guid222 = ((settled * numLeds) - dropped);
             if (!(true)) {
                 juniper::quit<Prelude::unit>();
             }
-            auto numLedsF = guid221;
+            auto pos = guid222;
             
-            (([&]() -> Prelude::unit {
-                int32_t guid222 = 0;
-                int32_t guid223 = (numLeds - 1);
-                for (int32_t i = guid222; i <= guid223; i++) {
-                    (([&]() -> Prelude::unit {
-                        auto guid224 = Math::min_((((i + 1) * numLeds) - (((1 - tPrime) * numLeds) * numLeds)), i);
-                        if (!(true)) {
-                            juniper::quit<Prelude::unit>();
-                        }
-                        auto pos = guid224;
-                        
-                        return (((0.000000 <= pos) && (numLeds > pos)) ? 
-setLedColor<t995, t996>(pos, interpolate<t997, t998>(red, green, (i / numLedsF)), leds)
-                        :
-                            Prelude::unit());
-                    })());
-                }
-                return {};
-            })());
-            return Prelude::unit();
+            (((0 <= falling) && (0 <= pos)) ? 
+                setLayerColor(progressLayer, pos, ledColor(falling))
+            :
+                Prelude::unit());
+            return endLayer(progressLayer);
         })());
     }
 }
 
 namespace Setting {
-    juniper::shared_ptr<Button::buttonState> bState = Button::state();
+    juniper::static_ref<Button::buttonState> bState = (juniper::static_ref<Button::buttonState>((([]() -> Button::buttonState{
+        Button::buttonState guid294;
+        guid294.actualState = Io::low();
+        guid294.lastState = Io::low();
+        guid294.lastDebounceTime = 0;
+        return guid294;
+    })())));
 }
 
 namespace Setting {
-    juniper::shared_ptr<Io::pinState> bEdgeState = (juniper::shared_ptr<Io::pinState>(new Io::pinState(Io::low())));
+    juniper::static_ref<Io::pinState> bEdgeState = (juniper::static_ref<Io::pinState>(Io::low()));
 }
 
 namespace Setting {
-    juniper::shared_ptr<Setting::timeSetting> numLedsLit = (juniper::shared_ptr<Setting::timeSetting>(new Setting::timeSetting((([&]() -> Setting::timeSetting{
+    juniper::static_ref<Setting::timeSetting> numLedsLit = (juniper::static_ref<Setting::timeSetting>((([]() -> Setting::timeSetting{
         Setting::timeSetting guid225;
         guid225.minutes = 0;
         guid225.fifteenSeconds = 0;
         return guid225;
-    })()))));
+    })())));
 }
 
 namespace Setting {
-    juniper::shared_ptr<Time::timerState> tState = Time::state();
+    juniper::static_ref<Time::timerState> tState = (juniper::static_ref<Time::timerState>((([]() -> Time::timerState{
+        Time::timerState guid265;
+        guid265.lastPulse = 0;
+        guid265.timer = 0;
+        return guid265;
+    })())));
 }
 
 namespace Setting {
-    juniper::shared_ptr<Io::pinState> cursorState = (juniper::shared_ptr<Io::pinState>(new Io::pinState(Io::low())));
+    juniper::static_ref<Io::pinState> cursorState = (juniper::static_ref<Io::pinState>(Io::low()));
 }
 
 namespace Setting {
-    juniper::shared_ptr<Prelude::tuple2<Io::pinState,Setting::timeSetting>> outputUpdateState = (juniper::shared_ptr<Prelude::tuple2<Io::pinState,Setting::timeSetting>>(new Prelude::tuple2<Io::pinState,Setting::timeSetting>((Prelude::tuple2<Io::pinState,Setting::timeSetting>{(*((cursorState).get())), (*((numLedsLit).get()))}))));
+    juniper::static_ref<juniper::tracked<Prelude::tuple2<Io::pinState,Setting::timeSetting>>> outputState = (juniper::static_ref<juniper::tracked<Prelude::tuple2<Io::pinState,Setting::timeSetting>>>(Signal::track<Prelude::tuple2<Io::pinState,Setting::timeSetting>>((Prelude::tuple2<Io::pinState,Setting::timeSetting>{(*((cursorState).get())), (*((numLedsLit).get()))}))));
 }
 
 namespace Setting {
-    juniper::shared_ptr<Prelude::tuple2<Io::pinState,Setting::timeSetting>> outputState = (juniper::shared_ptr<Prelude::tuple2<Io::pinState,Setting::timeSetting>>(new Prelude::tuple2<Io::pinState,Setting::timeSetting>((*((outputUpdateState).get())))));
+    juniper::static_ref<uint32_t> drawnGeneration = (juniper::static_ref<uint32_t>(0));
 }
 
 namespace Setting {
@@ -5251,14 +6787,50 @@ namespace Setting {
                 return guid226;
             })()));
             (*((Io::pinState*) (cursorState.get())) = Io::low());
-            (*((Prelude::tuple2<Io::pinState,Setting::timeSetting>*) (outputUpdateState.get())) = (Prelude::tuple2<Io::pinState,Setting::timeSetting>{(*((cursorState).get())), (*((numLedsLit).get()))}));
-            (*((Prelude::tuple2<Io::pinState,Setting::timeSetting>*) (outputState.get())) = (*((outputUpdateState).get())));
+            Signal::update<Prelude::tuple2<Io::pinState,Setting::timeSetting>>(outputState, (Prelude::tuple2<Io::pinState,Setting::timeSetting>{(*((cursorState).get())), (*((numLedsLit).get()))}));
+            (*((uint32_t*) (drawnGeneration.get())) = 0);
             (*((int32_t*) (timeRemaining.get())) = 0);
+            Time::cancel(tState);
+            (([&]() -> Prelude::unit {
+                edgecapture::discard();
+                return {};
+            })());
             return Prelude::unit();
         })());
     }
 }
 
+namespace Setting {
+    uint8_t pressAt(Io::pinState level, uint32_t time) {
+        return (([&]() -> uint8_t {
+            auto guid299 = (*((bState).get()));
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto lastState = (guid299).lastState;
+            auto actualState = (guid299).actualState;
+            
+            return (((level == lastState) && (level == actualState)) ? 
+                0
+            :
+                (([&]() -> uint8_t {
+                    auto guid295 = Io::risingEdge(Button::debounceAt(SignalExt::constant<Prelude::tuple2<Io::pinState,uint32_t>>((Prelude::tuple2<Io::pinState,uint32_t>{level, time})), bState), bEdgeState);
+                    return (((((guid295).signal).tag == 0) && true) ? 
+                        (([&]() -> uint8_t {
+                            return 1;
+                        })())
+                    :
+                        (true ? 
+                            (([&]() -> uint8_t {
+                                return 0;
+                            })())
+                        :
+                            juniper::quit<uint8_t>()));
+                })()));
+        })());
+    }
+}
+
 namespace Setting {
     Prelude::unit execute(juniper::shared_ptr<int32_t> timeRemaining) {
         return (([&]() -> Prelude::unit {
@@ -5268,13 +6840,63 @@ namespace Setting {
             }
             auto cursorSig = guid227;
             
-            auto guid228 = Io::risingEdge(Button::debounce(Io::digIn(buttonPin), bState), bEdgeState);
+            auto guid228 = (([&]() -> Prelude::sig<juniper::batch<Prelude::unit, 4>> {
+                auto guid267 = 0;
+                if (!(true)) {
+                    juniper::quit<Prelude::unit>();
+                }
+                auto presses = guid267;
+                
+                auto guid296 = true;
+                if (!(true)) {
+                    juniper::quit<Prelude::unit>();
+                }
+                auto captured = guid296;
+                
+                (([&]() -> Prelude::unit {
+                    while (captured) {
+                        (([&]() -> Prelude::unit {
+                            uint8_t guid300 = 0;
+                            if (!(true)) {
+                                juniper::quit<Prelude::unit>();
+                            }
+                            auto held = guid300;
+                            
+                            uint8_t guid297 = 0;
+                            if (!(true)) {
+                                juniper::quit<Prelude::unit>();
+                            }
+                            auto level = guid297;
+                            
+                            uint32_t guid298 = 0;
+                            if (!(true)) {
+                                juniper::quit<Prelude::unit>();
+                            }
+                            auto time = guid298;
+                            
+                            (([&]() -> Prelude::unit {
+                                captured = edgecapture::next(held, level, time);
+                                return {};
+                            })());
+                            (presses = (presses + pressAt(Io::intToPinState(held), time)));
+                            (presses = (presses + pressAt(Io::intToPinState(level), time)));
+                            return Prelude::unit();
+                        })());
+                    }
+                    return {};
+                })());
+                (([&]() -> Prelude::unit {
+                    TRACE_BUTTON(presses);
+                    return {};
+                })());
+                return Signal::repeated<Prelude::unit, 4>(Prelude::unit(), presses);
+            })());
             if (!(true)) {
                 juniper::quit<Prelude::unit>();
             }
             auto buttonSig = guid228;
             
-            auto guid229 = Signal::foldP<Prelude::unit, Setting::timeSetting>(juniper::function<Setting::timeSetting(Prelude::unit,Setting::timeSetting)>([=](Prelude::unit u, Setting::timeSetting prevSetting) mutable -> Setting::timeSetting { 
+            auto guid229 = Signal::foldP<Prelude::unit, Setting::timeSetting, 4>([=](Prelude::unit u, Setting::timeSetting prevSetting) mutable -> Setting::timeSetting { 
                 return (([&]() -> Setting::timeSetting {
                     auto guid230 = prevSetting;
                     if (!(true)) {
@@ -5301,27 +6923,21 @@ namespace Setting {
                                 return guid232;
                             })())));
                 })());
-             }), numLedsLit, buttonSig);
+             }, numLedsLit, buttonSig);
             if (!(true)) {
                 juniper::quit<Prelude::unit>();
             }
             auto numLedsLitUpdateSig = guid229;
             
-            auto guid233 = SignalExt::zip<Io::pinState, Setting::timeSetting>(cursorSig, numLedsLitUpdateSig, outputUpdateState);
-            if (!(true)) {
-                juniper::quit<Prelude::unit>();
-            }
-            auto outputUpdateSig = guid233;
-            
-            auto guid234 = Signal::latch<Prelude::tuple2<Io::pinState,Setting::timeSetting>>(outputUpdateSig, outputState);
+            auto guid234 = Signal::holdLatest<Io::pinState, Setting::timeSetting>(cursorSig, numLedsLitUpdateSig, outputState);
             if (!(true)) {
                 juniper::quit<Prelude::unit>();
             }
             auto outputSig = guid234;
             
-            return Signal::sink<Prelude::tuple2<Io::pinState,Setting::timeSetting>>(juniper::function<Prelude::unit(Prelude::tuple2<Io::pinState,Setting::timeSetting>)>([=](Prelude::tuple2<Io::pinState,Setting::timeSetting> out) mutable -> Prelude::unit { 
+            return Signal::sinkChanged<Prelude::tuple2<Io::pinState,Setting::timeSetting>>([=](juniper::slots_view<Prelude::tuple2<Io::pinState,Setting::timeSetting>> out) mutable -> Prelude::unit { 
                 return (([&]() -> Prelude::unit {
-                    auto guid235 = out;
+                    const auto& guid235 = Signal::slots<Prelude::tuple2<Io::pinState,Setting::timeSetting>>(out);
                     if (!(true)) {
                         juniper::quit<Prelude::unit>();
                     }
@@ -5329,28 +6945,26 @@ namespace Setting {
                     auto numMinutes = ((guid235).e2).minutes;
                     auto cursor = (guid235).e1;
                     
+                    FastLed::beginLayer(FastLed::progressLayer);
+                    FastLed::beginLayer(FastLed::cursorLayer);
                     (*((int32_t*) (timeRemaining.get())) = ((numMinutes * 60000) + (numFifteenSeconds * 15000)));
+                    FastLed::fill(FastLed::progressLayer, (([&]() -> FastLed::range{
+                        FastLed::range guid236;
+                        guid236.first = (numLeds - numMinutes);
+                        guid236.last = numLeds;
+                        return guid236;
+                    })()), blue);
+                    FastLed::fill(FastLed::progressLayer, (([&]() -> FastLed::range{
+                        FastLed::range guid238;
+                        guid238.first = (numLeds - (numMinutes + numFifteenSeconds));
+                        guid238.last = (numLeds - numMinutes);
+                        return guid238;
+                    })()), pink);
                     (([&]() -> Prelude::unit {
-                        int32_t guid236 = 0;
-                        int32_t guid237 = (numMinutes - 1);
-                        for (int32_t i = guid236; i <= guid237; i++) {
-                            FastLed::setLedColor<t1063, t1064>(((numLeds - i) - 1), blue, leds);
-                        }
-                        return {};
-                    })());
-                    (([&]() -> Prelude::unit {
-                        int32_t guid238 = 0;
-                        int32_t guid239 = (numFifteenSeconds - 1);
-                        for (int32_t i = guid238; i <= guid239; i++) {
-                            FastLed::setLedColor<t1069, t1070>(((numLeds - (numMinutes + i)) - 1), pink, leds);
-                        }
-                        return {};
-                    })());
-                    return (([&]() -> Prelude::unit {
                         auto guid240 = cursor;
                         return ((((guid240).tag == 0) && true) ? 
                             (([&]() -> Prelude::unit {
-                                return FastLed::setLedColor<FastLed::color, FastLed::fastLedStrip>(((numLeds - (numMinutes + numFifteenSeconds)) - 1), white, leds);
+                                return FastLed::setLayerColor(FastLed::cursorLayer, ((numLeds - (numMinutes + numFifteenSeconds)) - 1), white);
                             })())
                         :
                             (true ? 
@@ -5360,14 +6974,16 @@ namespace Setting {
                             :
                                 juniper::quit<Prelude::unit>()));
                     })());
+                    FastLed::endLayer(FastLed::progressLayer);
+                    return FastLed::endLayer(FastLed::cursorLayer);
                 })());
-             }), outputSig);
+             }, outputSig, drawnGeneration);
         })());
     }
 }
 
 namespace Paused {
-    Prelude::unit execute(juniper::shared_ptr<int32_t> timeRemaining, float totalTime) {
+    Prelude::unit execute(juniper::shared_ptr<int32_t> timeRemaining, int32_t totalTime) {
         return (([&]() -> Prelude::unit {
             auto guid241 = (*((timeRemaining).get()));
             if (!(true)) {
@@ -5377,274 +6993,411 @@ namespace Paused {
             
             Timing::execute(timeRemaining, totalTime);
             (*((int32_t*) (timeRemaining.get())) = t);
-            auto guid242 = (0.500000 * (Math::sin_((((2.000000 * Math::pi) * Time::now()) / 1000.000000)) + 1.000000));
+            auto guid242 = (((Time::now() % 1000) * 256) / 1000);
             if (!(true)) {
                 juniper::quit<Prelude::unit>();
             }
-            auto multiplier = guid242;
+            auto phase = guid242;
             
-            return (([&]() -> Prelude::unit {
-                int32_t guid243 = 0;
-                int32_t guid244 = (numLeds - 1);
-                for (int32_t i = guid243; i <= guid244; i++) {
+            auto guid243 = 0;
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto brightness = guid243;
+            
+            (([&]() -> Prelude::unit {
+                brightness = colormath::sin8(phase);
+                return {};
+            })());
+            return setBrightness(brightness);
+        })());
+    }
+}
+
+namespace Finale {
+    int32_t numLedsF = numLeds;
+}
+
+namespace Finale {
+    Prelude::unit execute() {
+        return (([&]() -> Prelude::unit {
+            FastLed::beginLayer(FastLed::backgroundLayer);
+            (([&]() -> Prelude::unit {
+                int32_t guid248 = 0;
+                int32_t guid249 = (numLeds - 1);
+                for (int32_t i = guid248; i <= guid249; i++) {
                     (([&]() -> Prelude::unit {
-                        auto guid245 = FastLed::getLedColor<t1095>(i, leds);
+                        auto guid250 = Time::now();
                         if (!(true)) {
                             juniper::quit<Prelude::unit>();
                         }
-                        auto b = (guid245).b;
-                        auto g = (guid245).g;
-                        auto r = (guid245).r;
+                        auto t = guid250;
                         
-                        auto guid246 = (([&]() -> FastLed::color{
-                            FastLed::color guid247;
-                            guid247.r = (r * multiplier);
-                            guid247.g = (g * multiplier);
-                            guid247.b = (b * multiplier);
-                            return guid247;
+                        auto guid251 = (((i / numLedsF) * 1000) + t);
+                        if (!(true)) {
+                            juniper::quit<Prelude::unit>();
+                        }
+                        auto x = guid251;
+                        
+                        auto guid252 = (([&]() -> FastLed::color{
+                            FastLed::color guid253;
+                            guid253.r = (50 * Math::sin_((((2.000000 * Math::pi) * x) / 1000.000000)));
+                            guid253.g = (50 * Math::cos_((((2.000000 * Math::pi) * x) / 1000.000000)));
+                            guid253.b = (50 * Math::sin_((((2.000000 * Math::pi) * (x + (Math::pi / 2.000000))) / 1000.000000)));
+                            return guid253;
                         })());
                         if (!(true)) {
                             juniper::quit<Prelude::unit>();
                         }
-                        auto newColor = guid246;
+                        auto color = guid252;
                         
-                        return setLedColor<t1099, t1100>(i, newColor, leds);
+                        return FastLed::setLayerColor(FastLed::backgroundLayer, i, color);
                     })());
                 }
                 return {};
             })());
+            return FastLed::endLayer(FastLed::backgroundLayer);
         })());
     }
 }
 
-namespace Finale {
-    int32_t numLedsF = numLeds;
+namespace Program {
+    juniper::static_ref<Prelude::maybe<Accelerometer::orientation>> accState = (juniper::static_ref<Prelude::maybe<Accelerometer::orientation>>(nothing<Accelerometer::orientation>()));
 }
 
-namespace Finale {
-    Prelude::unit execute() {
-        return (([&]() -> Prelude::unit {
-            int32_t guid248 = 0;
-            int32_t guid249 = (numLeds - 1);
-            for (int32_t i = guid248; i <= guid249; i++) {
-                (([&]() -> Prelude::unit {
-                    auto guid250 = Time::now();
-                    if (!(true)) {
-                        juniper::quit<Prelude::unit>();
-                    }
-                    auto t = guid250;
-                    
-                    auto guid251 = (((i / numLedsF) * 1000) + t);
-                    if (!(true)) {
-                        juniper::quit<Prelude::unit>();
-                    }
-                    auto x = guid251;
-                    
-                    auto guid252 = (([&]() -> FastLed::color{
-                        FastLed::color guid253;
-                        guid253.r = (50 * Math::sin_((((2.000000 * Math::pi) * x) / 1000.000000)));
-                        guid253.g = (50 * Math::cos_((((2.000000 * Math::pi) * x) / 1000.000000)));
-                        guid253.b = (50 * Math::sin_((((2.000000 * Math::pi) * (x + (Math::pi / 2.000000))) / 1000.000000)));
-                        return guid253;
-                    })());
-                    if (!(true)) {
-                        juniper::quit<Prelude::unit>();
-                    }
-                    auto color = guid252;
-                    
-                    return FastLed::setLedColor<t1113, t1114>(i, color, leds);
-                })());
-            }
-            return {};
-        })());
-    }
+namespace Program {
+    juniper::static_ref<Program::mode> modeState = (juniper::static_ref<Program::mode>(setting()));
+}
+
+namespace Program {
+    juniper::static_ref<Program::mode> renderedMode = (juniper::static_ref<Program::mode>(setting()));
+}
+
+namespace Program {
+    juniper::static_ref<int32_t> timeRemaining = (juniper::static_ref<int32_t>(0));
 }
 
 namespace Program {
-    juniper::shared_ptr<Prelude::maybe<Accelerometer::orientation>> accState = (juniper::shared_ptr<Prelude::maybe<Accelerometer::orientation>>(new Prelude::maybe<Accelerometer::orientation>(nothing<Accelerometer::orientation>())));
+    juniper::static_ref<int32_t> totalTime = (juniper::static_ref<int32_t>(0));
 }
 
 namespace Program {
-    juniper::shared_ptr<Program::mode> modeState = (juniper::shared_ptr<Program::mode>(new Program::mode(setting())));
+    uint32_t sensorInterval = 50;
 }
 
 namespace Program {
-    juniper::shared_ptr<int32_t> timeRemaining = (juniper::shared_ptr<int32_t>(new int32_t(0)));
+    uint32_t renderInterval = 20;
 }
 
 namespace Program {
-    juniper::shared_ptr<int32_t> totalTime = (juniper::shared_ptr<int32_t>(new int32_t(0)));
+    juniper::static_ref<Time::domainState> sensorDomain = (juniper::static_ref<Time::domainState>(Time::domain(sensorInterval)));
+}
+
+namespace Program {
+    juniper::static_ref<Time::domainState> renderDomain = (juniper::static_ref<Time::domainState>(Time::domain(renderInterval)));
+}
+
+namespace Program {
+    juniper::static_ref<Prelude::maybe<Accelerometer::orientation>> accSample = (juniper::static_ref<Prelude::maybe<Accelerometer::orientation>>(nothing<Accelerometer::orientation>()));
 }
 
 namespace Program {
     Prelude::unit setup() {
-        return Time::wait(500);
+        return (([&]() -> Prelude::unit {
+            FastLed::begin();
+            (([&]() -> Prelude::unit {
+                PROFILE_BEGIN();
+                return {};
+            })());
+            (([&]() -> Prelude::unit {
+                TRACE_BEGIN();
+                return {};
+            })());
+            (([&]() -> Prelude::unit {
+                scheduler::watch(buttonPin);
+                return {};
+            })());
+            (([&]() -> Prelude::unit {
+                edgecapture::begin(buttonPin);
+                return {};
+            })());
+            return Time::wait(500);
+        })());
     }
 }
 
 namespace Program {
-    Prelude::unit clearDisplay() {
-        return (([&]() -> Prelude::unit {
-            uint16_t guid254 = 0;
-            uint16_t guid255 = (numLeds - 1);
-            for (uint16_t i = guid254; i <= guid255; i++) {
-                FastLed::setLedColor<t1125, t1126>(i, blank, leds);
-            }
-            return {};
+    Program::flip orientationToFlip(Accelerometer::orientation o) {
+        return (([&]() -> Program::flip {
+            auto guid258 = o;
+            return ((((guid258).tag == 0) && true) ? 
+                (([&]() -> Program::flip {
+                    return flipUp();
+                })())
+            :
+                ((((guid258).tag == 1) && true) ? 
+                    (([&]() -> Program::flip {
+                        return flipDown();
+                    })())
+                :
+                    (true ? 
+                        (([&]() -> Program::flip {
+                            return flipFlat();
+                        })())
+                    :
+                        juniper::quit<Program::flip>())));
         })());
     }
 }
 
 namespace Program {
-    Prelude::unit main() {
-        return (([&]() -> Prelude::unit {
-            setup();
-            return (([&]() -> Prelude::unit {
-                while (true) {
-                    (([&]() -> Prelude::unit {
-                        clearDisplay();
-                        auto guid256 = Signal::dropRepeats<Accelerometer::orientation>(Accelerometer::getSignal(), accState);
-                        if (!(true)) {
-                            juniper::quit<Prelude::unit>();
-                        }
-                        auto accSig = guid256;
-                        
-                        auto guid257 = Signal::map<Accelerometer::orientation, Program::flip>(juniper::function<Program::flip(Accelerometer::orientation)>([=](Accelerometer::orientation o) mutable -> Program::flip { 
-                            return (([&]() -> Program::flip {
-                                auto guid258 = o;
-                                return ((((guid258).tag == 0) && true) ? 
-                                    (([&]() -> Program::flip {
-                                        return flipUp();
+    Program::mode nextMode(Prelude::maybe<Program::flip> maybeFlipEvent, Program::mode prevMode) {
+        return (((prevMode == timing()) && ((*((timeRemaining).get())) <= 0)) ? 
+            finale()
+        :
+            (([&]() -> Program::mode {
+                auto guid261 = maybeFlipEvent;
+                return ((((guid261).tag == 0) && true) ? 
+                    (([&]() -> Program::mode {
+                        auto flipEvent = (guid261).just;
+                        return (([&]() -> Program::mode {
+                            auto guid262 = (Prelude::tuple2<Program::flip,Program::mode>{flipEvent, prevMode});
+                            return (((((guid262).e2).tag == 0) && ((((guid262).e1).tag == 0) && true)) ? 
+                                (([&]() -> Program::mode {
+                                    return (([&]() -> Program::mode {
+                                        (*((int32_t*) (totalTime.get())) = (*((timeRemaining).get())));
+                                        Timing::reset();
+                                        return timing();
+                                    })());
+                                })())
+                            :
+                                (((((guid262).e2).tag == 2) && ((((guid262).e1).tag == 0) && true)) ? 
+                                    (([&]() -> Program::mode {
+                                        return timing();
                                     })())
                                 :
-                                    ((((guid258).tag == 1) && true) ? 
-                                        (([&]() -> Program::flip {
-                                            return flipDown();
+                                    (((((guid262).e2).tag == 1) && ((((guid262).e1).tag == 1) && true)) ? 
+                                        (([&]() -> Program::mode {
+                                            return (([&]() -> Program::mode {
+                                                Setting::reset(timeRemaining);
+                                                return setting();
+                                            })());
                                         })())
                                     :
-                                        (true ? 
-                                            (([&]() -> Program::flip {
-                                                return flipFlat();
+                                        (((((guid262).e2).tag == 2) && ((((guid262).e1).tag == 1) && true)) ? 
+                                            (([&]() -> Program::mode {
+                                                return (([&]() -> Program::mode {
+                                                    Setting::reset(timeRemaining);
+                                                    return setting();
+                                                })());
                                             })())
                                         :
-                                            juniper::quit<Program::flip>())));
-                            })());
-                         }), accSig);
-                        if (!(true)) {
-                            juniper::quit<Prelude::unit>();
-                        }
-                        auto flipSig = guid257;
-                        
-                        auto guid259 = SignalExt::meta<Program::flip>(flipSig);
-                        if (!(true)) {
-                            juniper::quit<Prelude::unit>();
-                        }
-                        auto metaFlipSig = guid259;
-                        
-                        auto guid260 = Signal::foldP<Prelude::maybe<Program::flip>, Program::mode>(juniper::function<Program::mode(Prelude::maybe<Program::flip>,Program::mode)>([=](Prelude::maybe<Program::flip> maybeFlipEvent, Program::mode prevMode) mutable -> Program::mode { 
-                            return (((prevMode == timing()) && ((*((timeRemaining).get())) <= 0)) ? 
-                                finale()
-                            :
-                                (([&]() -> Program::mode {
-                                    auto guid261 = maybeFlipEvent;
-                                    return ((((guid261).tag == 0) && true) ? 
-                                        (([&]() -> Program::mode {
-                                            auto flipEvent = (guid261).just;
-                                            return (([&]() -> Program::mode {
-                                                auto guid262 = (Prelude::tuple2<Program::flip,Program::mode>{flipEvent, prevMode});
-                                                return (((((guid262).e2).tag == 0) && ((((guid262).e1).tag == 0) && true)) ? 
+                                            (((((guid262).e2).tag == 3) && ((((guid262).e1).tag == 1) && true)) ? 
+                                                (([&]() -> Program::mode {
+                                                    return (([&]() -> Program::mode {
+                                                        Setting::reset(timeRemaining);
+                                                        return setting();
+                                                    })());
+                                                })())
+                                            :
+                                                (((((guid262).e2).tag == 1) && ((((guid262).e1).tag == 2) && true)) ? 
                                                     (([&]() -> Program::mode {
-                                                        return (([&]() -> Program::mode {
-                                                            (*((int32_t*) (totalTime.get())) = (*((timeRemaining).get())));
-                                                            Timing::reset();
-                                                            return timing();
-                                                        })());
+                                                        return paused();
                                                     })())
                                                 :
-                                                    (((((guid262).e2).tag == 2) && ((((guid262).e1).tag == 0) && true)) ? 
+                                                    (true ? 
                                                         (([&]() -> Program::mode {
-                                                            return timing();
+                                                            return prevMode;
                                                         })())
                                                     :
-                                                        (((((guid262).e2).tag == 1) && ((((guid262).e1).tag == 1) && true)) ? 
-                                                            (([&]() -> Program::mode {
-                                                                return (([&]() -> Program::mode {
-                                                                    Setting::reset(timeRemaining);
-                                                                    return setting();
-                                                                })());
-                                                            })())
-                                                        :
-                                                            (((((guid262).e2).tag == 2) && ((((guid262).e1).tag == 1) && true)) ? 
-                                                                (([&]() -> Program::mode {
-                                                                    return (([&]() -> Program::mode {
-                                                                        Setting::reset(timeRemaining);
-                                                                        return setting();
-                                                                    })());
-                                                                })())
-                                                            :
-                                                                (((((guid262).e2).tag == 3) && ((((guid262).e1).tag == 1) && true)) ? 
-                                                                    (([&]() -> Program::mode {
-                                                                        return (([&]() -> Program::mode {
-                                                                            Setting::reset(timeRemaining);
-                                                                            return setting();
-                                                                        })());
-                                                                    })())
-                                                                :
-                                                                    (((((guid262).e2).tag == 1) && ((((guid262).e1).tag == 2) && true)) ? 
-                                                                        (([&]() -> Program::mode {
-                                                                            return paused();
-                                                                        })())
-                                                                    :
-                                                                        (true ? 
-                                                                            (([&]() -> Program::mode {
-                                                                                return prevMode;
-                                                                            })())
-                                                                        :
-                                                                            juniper::quit<Program::mode>())))))));
-                                            })());
-                                        })())
-                                    :
-                                        (true ? 
-                                            (([&]() -> Program::mode {
-                                                return prevMode;
-                                            })())
-                                        :
-                                            juniper::quit<Program::mode>()));
-                                })()));
-                         }), modeState, metaFlipSig);
-                        if (!(true)) {
-                            juniper::quit<Prelude::unit>();
-                        }
-                        auto modeSig = guid260;
-                        
-                        Signal::sink<Program::mode>(juniper::function<Prelude::unit(Program::mode)>([=](Program::mode m) mutable -> Prelude::unit { 
+                                                        juniper::quit<Program::mode>())))))));
+                        })());
+                    })())
+                :
+                    (true ? 
+                        (([&]() -> Program::mode {
+                            return prevMode;
+                        })())
+                    :
+                        juniper::quit<Program::mode>()));
+            })()));
+    }
+}
+
+namespace Program {
+    Prelude::unit executeMode(Program::mode m) {
+        return (([&]() -> Prelude::unit {
+            ((m != (*((renderedMode).get()))) ? 
+                (([&]() -> Prelude::unit {
+                    FastLed::resetLayers();
+                    (*((Program::mode*) (renderedMode.get())) = m);
+                    return Prelude::unit();
+                })())
+            :
+                Prelude::unit());
+            return (([&]() -> Prelude::unit {
+                auto guid263 = m;
+                return ((((guid263).tag == 0) && true) ? 
+                    (([&]() -> Prelude::unit {
+                        return (([&]() -> Prelude::unit {
+                            (([&]() -> Prelude::unit {
+                                PROFILE_MARK(settingExecute);
+                                return {};
+                            })());
+                            return Setting::execute(timeRemaining);
+                        })());
+                    })())
+                :
+                    ((((guid263).tag == 1) && true) ? 
+                        (([&]() -> Prelude::unit {
                             return (([&]() -> Prelude::unit {
-                                auto guid263 = m;
-                                return ((((guid263).tag == 0) && true) ? 
+                                (([&]() -> Prelude::unit {
+                                    PROFILE_MARK(timingExecute);
+                                    return {};
+                                })());
+                                Time::demand(renderDomain);
+                                return Timing::execute(timeRemaining, (*((totalTime).get())));
+                            })());
+                        })())
+                    :
+                        ((((guid263).tag == 2) && true) ? 
+                            (([&]() -> Prelude::unit {
+                                return (([&]() -> Prelude::unit {
                                     (([&]() -> Prelude::unit {
-                                        return Setting::execute(timeRemaining);
-                                    })())
-                                :
-                                    ((((guid263).tag == 1) && true) ? 
+                                        PROFILE_MARK(pausedExecute);
+                                        return {};
+                                    })());
+                                    Time::demand(renderDomain);
+                                    return Paused::execute(timeRemaining, (*((totalTime).get())));
+                                })());
+                            })())
+                        :
+                            ((((guid263).tag == 3) && true) ? 
+                                (([&]() -> Prelude::unit {
+                                    return (([&]() -> Prelude::unit {
                                         (([&]() -> Prelude::unit {
-                                            return Timing::execute(timeRemaining, (*((totalTime).get())));
-                                        })())
-                                    :
-                                        ((((guid263).tag == 2) && true) ? 
-                                            (([&]() -> Prelude::unit {
-                                                return Paused::execute(timeRemaining, (*((totalTime).get())));
-                                            })())
-                                        :
-                                            ((((guid263).tag == 3) && true) ? 
-                                                (([&]() -> Prelude::unit {
-                                                    return Finale::execute();
-                                                })())
-                                            :
-                                                juniper::quit<Prelude::unit>()))));
-                            })());
-                         }), modeSig);
-                        return FastLed::show();
-                    })());
+                                            PROFILE_MARK(finaleExecute);
+                                            return {};
+                                        })());
+                                        Time::demand(renderDomain);
+                                        return Finale::execute();
+                                    })());
+                                })())
+                            :
+                                juniper::quit<Prelude::unit>()))));
+            })());
+        })());
+    }
+}
+
+namespace Program {
+    Prelude::unit showFrame(uint32_t t) {
+        return (([&]() -> Prelude::unit {
+            (([&]() -> Prelude::unit {
+                PROFILE_MARK(show);
+                return {};
+            })());
+            FastLed::composite();
+            return FastLed::show();
+        })());
+    }
+}
+
+namespace Program {
+    Prelude::unit tick() {
+        return (([&]() -> Prelude::unit {
+            (([&]() -> Prelude::unit {
+                juniper::frame_begin();
+                return {};
+            })());
+            (([&]() -> Prelude::unit {
+                TRACE_FRAME_BEGIN();
+                return {};
+            })());
+            (([&]() -> Prelude::unit {
+                scheduler::frameBegin();
+                return {};
+            })());
+            (([&]() -> Prelude::unit {
+                PROFILE_MARK(accelerometer);
+                return {};
+            })());
+            auto guid272 = Time::tick(sensorDomain);
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto sensorTick = guid272;
+            
+            Time::demand(sensorDomain);
+            auto guid266 = Signal::sampleHold<uint32_t, Accelerometer::orientation>(Accelerometer::getSignal, sensorTick, accSample);
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto accReading = guid266;
+            
+            (([&]() -> Prelude::unit {
+                PROFILE_MARK(modeFold);
+                return {};
+            })());
+            auto guid256 = Signal::dropRepeats<Accelerometer::orientation>(accReading, accState);
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto accSig = guid256;
+            
+            auto guid257 = Signal::map<Accelerometer::orientation, Program::flip>(orientationToFlip, accSig);
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto flipSig = guid257;
+            
+            auto guid259 = SignalExt::meta<Program::flip>(flipSig);
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto metaFlipSig = guid259;
+            
+            auto guid260 = Signal::foldP<Prelude::maybe<Program::flip>, Program::mode>(nextMode, modeState, metaFlipSig);
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto modeSig = guid260;
+            
+            auto guid273 = Time::tick(renderDomain);
+            if (!(true)) {
+                juniper::quit<Prelude::unit>();
+            }
+            auto renderTick = guid273;
+            
+            Signal::sink<Program::mode>(executeMode, Signal::gate<uint32_t, Program::mode>(renderTick, modeSig));
+            Signal::sink<uint32_t>(showFrame, renderTick);
+            (([&]() -> Prelude::unit {
+                PROFILE_FRAME_END();
+                return {};
+            })());
+            (([&]() -> Prelude::unit {
+                TRACE_FRAME_END();
+                return {};
+            })());
+            (([&]() -> Prelude::unit {
+                juniper::frame_end();
+                return {};
+            })());
+            return (([&]() -> Prelude::unit {
+                scheduler::sleep();
+                return {};
+            })());
+        })());
+    }
+}
+
+namespace Program {
+    Prelude::unit main() {
+        return (([&]() -> Prelude::unit {
+            setup();
+            return (([&]() -> Prelude::unit {
+                while (true) {
+                    tick();
                 }
                 return {};
             })());